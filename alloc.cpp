@@ -0,0 +1,138 @@
+#include "alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+const char* phaseNames[PHASE_COUNT] = { "other", "events", "update", "render", "present" };
+
+static thread_local Phase currentPhase = PHASE_OTHER;
+
+static std::atomic<unsigned int> allocations[PHASE_COUNT];
+static std::atomic<size_t> bytes[PHASE_COUNT];
+static std::atomic<unsigned int> surfaces;
+static std::atomic<unsigned int> textures;
+
+void allocSetPhase(Phase phase) {
+    currentPhase = phase;
+}
+
+void allocTrackSurface() {
+    surfaces++;
+}
+
+void allocTrackTexture() {
+    textures++;
+}
+
+void allocEndFrame(struct AllocFrame* frame) {
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        frame->allocations[i] = allocations[i].exchange(0);
+        frame->bytes[i] = bytes[i].exchange(0);
+    }
+    frame->surfaces = surfaces.exchange(0);
+    frame->textures = textures.exchange(0);
+}
+
+unsigned int allocTotal(const struct AllocFrame* frame) {
+    unsigned int total = frame->surfaces + frame->textures;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        total += frame->allocations[i];
+    }
+    return total;
+}
+
+void allocPrint(const struct AllocFrame* frame, int frames) {
+    printf("Allocations per frame:");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        printf(" %s %.1f (%.0f B)", phaseNames[i], (float)frame->allocations[i] / frames, (float)frame->bytes[i] / frames);
+    }
+    printf(" - surfaces %.1f, textures %.1f\n", (float)frame->surfaces / frames, (float)frame->textures / frames);
+}
+
+// Global allocation hooks
+static void* trackedAlloc(size_t size) {
+    allocations[currentPhase]++;
+    bytes[currentPhase] += size;
+
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size) {
+    return trackedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return trackedAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return trackedAlloc(size);
+    } catch (...) {
+        return NULL;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return trackedAlloc(size);
+    } catch (...) {
+        return NULL;
+    }
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+// Frame arena
+bool arenaInit(struct FrameArena* arena, size_t size) {
+    arena->data = (uint8_t*)malloc(size);
+    arena->size = arena->data != NULL ? size : 0;
+    arena->used = 0;
+    arena->peak = 0;
+    return arena->data != NULL;
+}
+
+void arenaFree(struct FrameArena* arena) {
+    free(arena->data);
+    arena->data = NULL;
+    arena->size = arena->used = 0;
+}
+
+void* arenaAlloc(struct FrameArena* arena, size_t size, size_t align) {
+
+    size_t start = (arena->used + align - 1) & ~(align - 1);
+    if (start + size > arena->size) {
+        return NULL;
+    }
+
+    arena->used = start + size;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+
+    return arena->data + start;
+}
+
+void arenaReset(struct FrameArena* arena) {
+    arena->used = 0;
+}
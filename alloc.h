@@ -0,0 +1,58 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frame phases allocations are charged to
+enum Phase {
+    PHASE_OTHER,
+    PHASE_EVENTS,
+    PHASE_UPDATE,
+    PHASE_RENDER,
+    PHASE_PRESENT,
+    PHASE_COUNT
+};
+
+extern const char* phaseNames[PHASE_COUNT];
+
+// Heap traffic since the last allocEndFrame(). operator new and delete are
+// replaced to count it, SDL surfaces and textures are counted by their callers.
+struct AllocFrame {
+    unsigned int allocations[PHASE_COUNT];
+    size_t bytes[PHASE_COUNT];
+    unsigned int surfaces;
+    unsigned int textures;
+};
+
+// Charges the calling thread's allocations to phase
+void allocSetPhase(Phase phase);
+
+// Counts a successful SDL surface or texture creation, which bypasses operator new
+void allocTrackSurface();
+void allocTrackTexture();
+
+// Hands out the counters and starts a new frame
+void allocEndFrame(struct AllocFrame* frame);
+
+// Total allocations of any kind in a frame
+unsigned int allocTotal(const struct AllocFrame* frame);
+
+void allocPrint(const struct AllocFrame* frame, int frames);
+
+// Bump allocator for per-frame scratch data, reset once a frame
+struct FrameArena {
+    uint8_t* data = NULL;
+    size_t size = 0;
+    size_t used = 0;
+    size_t peak = 0;
+};
+
+bool arenaInit(struct FrameArena* arena, size_t size);
+void arenaFree(struct FrameArena* arena);
+
+// Returns NULL when the arena is full
+void* arenaAlloc(struct FrameArena* arena, size_t size, size_t align = 16);
+void arenaReset(struct FrameArena* arena);
+
+#endif
@@ -0,0 +1,242 @@
+#include "client.h"
+
+#include <stdio.h>
+
+bool clientConnect(struct NetClient* client, const char* host, int port) {
+
+    if (!netResolve(host, port, &client->server)) {
+        return false;
+    }
+
+    if (!netOpen(&client->sock, 0)) {
+        return false;
+    }
+
+    client->connected = false;
+    client->lastConnectTime = netTime() - CONNECT_RETRY;
+
+    return true;
+}
+
+void clientDisconnect(struct NetClient* client) {
+
+    if (client->connected) {
+        uint8_t packet = MSG_DISCONNECT;
+        client->sock.shim = NetShim();
+        netSend(&client->sock, &client->server, &packet, 1);
+    }
+
+    netClose(&client->sock);
+    client->connected = false;
+}
+
+static struct NetState* findState(struct NetClient* client, uint32_t tick) {
+    struct NetState* state = &client->history[tick % NET_HISTORY];
+    return tick != 0 && state->tick == tick ? state : NULL;
+}
+
+static void readSnapshot(struct NetClient* client, const uint8_t* data, int size) {
+
+    if (size < 14) {
+        return;
+    }
+
+    uint32_t tick = netGet32(data + 1);
+    uint32_t baseTick = netGet32(data + 5);
+    uint32_t lastSeq = netGet32(data + 9);
+    int slot = data[13];
+
+    // Stale or reordered
+    if (tick <= client->newestTick || slot >= MAX_SURVIVORS) {
+        return;
+    }
+
+    const struct NetState* base = NULL;
+    if (baseTick != NET_NO_BASE) {
+        base = findState(client, baseTick);
+        if (base == NULL) {
+            return;
+        }
+    }
+
+    struct NetState* state = &client->history[tick % NET_HISTORY];
+    int eventSize = netReadEvents(data + 14, size - 14, client->events[tick % NET_HISTORY], &client->eventCounts[tick % NET_HISTORY]);
+    if (eventSize < 0 || !netReadDelta(base, state, data + 14 + eventSize, size - 14 - eventSize) || !netValidState(state)) {
+        state->tick = 0;
+        return;
+    }
+    state->tick = tick;
+
+    client->newestTick = tick;
+    client->ackedSeq = lastSeq;
+    client->slot = slot;
+}
+
+static void sendInput(struct NetClient* client) {
+
+    uint8_t packet[10 + NET_INPUT_REDUNDANCY];
+
+    int count = client->inputSeq < (uint32_t)NET_INPUT_REDUNDANCY ? client->inputSeq : NET_INPUT_REDUNDANCY;
+
+    packet[0] = MSG_INPUT;
+    netPut32(packet + 1, client->newestTick != 0 ? client->newestTick : NET_NO_BASE);
+    netPut32(packet + 5, client->inputSeq);
+    packet[9] = count;
+    for (int i = 0; i < count; i++) {
+        packet[10 + i] = client->inputs[(client->inputSeq - count + 1 + i) % NET_HISTORY];
+    }
+
+    netSend(&client->sock, &client->server, packet, 10 + count);
+}
+
+void clientUpdate(struct NetClient* client, uint8_t input) {
+
+    // Ask for a slot until the server answers
+    if (!client->connected && netTime() - client->lastConnectTime >= (uint32_t)CONNECT_RETRY) {
+        uint8_t packet = MSG_CONNECT;
+        netSend(&client->sock, &client->server, &packet, 1);
+        client->lastConnectTime = netTime();
+    }
+
+    if (client->connected) {
+        client->inputSeq++;
+        client->inputs[client->inputSeq % NET_HISTORY] = input;
+        sendInput(client);
+    }
+
+    netFlush(&client->sock);
+
+    // Read everything that arrived
+    uint32_t previousTick = client->newestTick;
+    uint8_t data[NET_MAX_PACKET];
+    struct NetAddress from;
+    int size;
+    while ((size = netReceive(&client->sock, &from, data, sizeof(data))) > 0) {
+
+        if (!netSameAddress(&from, &client->server)) {
+            continue;
+        }
+
+        switch (data[0]) {
+            case MSG_ACCEPT:
+                if (!client->connected && size >= 2) {
+                    client->connected = true;
+                    client->slot = data[1];
+                    printf("Connected as survivor %d\n", client->slot);
+                }
+                break;
+            case MSG_REJECT:
+                printf("Server is full!\n");
+                break;
+            case MSG_SNAPSHOT:
+                if (client->connected) {
+                    readSnapshot(client, data, size);
+                }
+                break;
+        }
+    }
+
+    if (client->newestTick == 0) {
+        return;
+    }
+
+    // Prediction: rebuild from the newest authoritative state and replay
+    // every input the server has not seen yet, otherwise just step forward
+    uint8_t inputs[MAX_SURVIVORS] = { 0 };
+    if (client->newestTick != previousTick) {
+        netRestore(findState(client, client->newestTick), &client->predicted);
+
+        uint32_t first = client->ackedSeq + 1;
+        if (client->inputSeq - client->ackedSeq > (uint32_t)NET_HISTORY) {
+            first = client->inputSeq - NET_HISTORY + 1;
+        }
+
+        for (uint32_t seq = first; seq <= client->inputSeq; seq++) {
+            inputs[client->slot] = client->inputs[seq % NET_HISTORY];
+            gameUpdate(&client->predicted, inputs);
+        }
+    } else {
+        inputs[client->slot] = input;
+        gameUpdate(&client->predicted, inputs);
+    }
+
+    // Interpolation clock, nudged towards a fixed delay behind the newest snapshot
+    float target = (float)client->newestTick - INTERP_DELAY;
+    client->renderTick += 1;
+    if (client->renderTick < target - NET_HISTORY / 2 || client->renderTick > target + INTERP_DELAY) {
+        client->renderTick = target;
+    } else {
+        client->renderTick += (target - client->renderTick) * 0.05f;
+    }
+}
+
+bool clientView(struct NetClient* client, struct Game* view) {
+
+    if (client->newestTick == 0) {
+        return false;
+    }
+
+    // Snapshots on both sides of the render clock
+    uint32_t renderTick = client->renderTick > 0 ? (uint32_t)client->renderTick : 0;
+    const struct NetState* a = NULL;
+    const struct NetState* b = NULL;
+
+    for (uint32_t tick = renderTick; tick + NET_HISTORY / 2 > renderTick && tick > 0; tick--) {
+        if ((a = findState(client, tick)) != NULL) {
+            break;
+        }
+    }
+
+    for (uint32_t tick = renderTick + 1; tick <= client->newestTick; tick++) {
+        if ((b = findState(client, tick)) != NULL) {
+            break;
+        }
+    }
+
+    if (a == NULL) {
+        a = b != NULL ? b : findState(client, client->newestTick);
+    }
+
+    struct NetState lerped;
+    if (b != NULL && b != a) {
+        netLerp(a, b, (client->renderTick - a->tick) / (b->tick - a->tick), &lerped);
+    } else {
+        lerped = *a;
+    }
+
+    netRestore(&lerped, view);
+
+    // Our own survivor comes from the prediction, HUD from the newest state
+    view->survivors[client->slot] = client->predicted.survivors[client->slot];
+    view->score = client->predicted.score;
+
+    // Events of everyone else when the render clock reaches their tick, so
+    // effects line up with the interpolated zombies. Skip any backlog.
+    if (client->eventTick == 0 || renderTick < client->eventTick || renderTick - client->eventTick > (uint32_t)NET_HISTORY / 2) {
+        client->eventTick = renderTick;
+    }
+
+    for (; client->eventTick < renderTick; client->eventTick++) {
+        uint32_t tick = client->eventTick + 1;
+        if (findState(client, tick) == NULL) {
+            continue;
+        }
+
+        const struct Event* events = client->events[tick % NET_HISTORY];
+        for (int i = 0; i < client->eventCounts[tick % NET_HISTORY]; i++) {
+            if (events[i].source != client->slot && view->eventCount < EVENT_COUNT) {
+                view->events[view->eventCount++] = events[i];
+            }
+        }
+    }
+
+    // Our own survivor's, as soon as we predict them
+    for (int i = 0; i < client->predicted.eventCount; i++) {
+        const struct Event* event = &client->predicted.events[i];
+        if (event->source == client->slot && view->eventCount < EVENT_COUNT) {
+            view->events[view->eventCount++] = *event;
+        }
+    }
+
+    return true;
+}
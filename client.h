@@ -0,0 +1,55 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "game.h"
+#include "net.h"
+
+// Remote entities are drawn this many ticks in the past so there is
+// always a second snapshot to interpolate towards
+const int INTERP_DELAY = 6;
+
+// Resend period for connection requests
+const int CONNECT_RETRY = 500;
+
+struct NetClient {
+    struct NetSocket sock;
+    struct NetAddress server;
+    bool connected = false;
+    int slot = -1;
+    uint32_t lastConnectTime = 0;
+
+    // Received snapshots and their events, indexed by tick % NET_HISTORY
+    struct NetState history[NET_HISTORY];
+    struct Event events[NET_HISTORY][EVENT_COUNT];
+    int eventCounts[NET_HISTORY];
+    uint32_t newestTick = 0;
+
+    // Last tick whose events went out with the view
+    uint32_t eventTick = 0;
+
+    // Sent inputs, indexed by sequence % NET_HISTORY
+    uint8_t inputs[NET_HISTORY];
+    uint32_t inputSeq = 0;
+
+    // Last input the server had applied in the newest snapshot
+    uint32_t ackedSeq = 0;
+
+    // Newest snapshot with the unacknowledged inputs replayed on top
+    struct Game predicted;
+
+    float renderTick = 0;
+};
+
+bool clientConnect(struct NetClient* client, const char* host, int port);
+void clientDisconnect(struct NetClient* client);
+
+// Sends this tick's input, reads snapshots and advances the prediction
+void clientUpdate(struct NetClient* client, uint8_t input);
+
+// Builds the game to draw: interpolated remote state plus the predicted
+// local survivor. Its events are the ones the render clock passed since the
+// last call, except our own survivor's, which come from the prediction.
+// Returns false until the first snapshot arrived.
+bool clientView(struct NetClient* client, struct Game* view);
+
+#endif
@@ -0,0 +1,244 @@
+#include "env.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include "game.h"
+
+const int ENV_OBS_SIZE = ENV_SURVIVOR_OBS + ZOMBIE_COUNT * ENV_ZOMBIE_OBS;
+
+// Reward for losing a survivor, each zombie knocked off the platform is worth +1
+const float DEATH_REWARD = -1.0f;
+
+struct Env {
+    int count;
+    int maxSteps;
+    struct Game* games;
+    int* steps;
+
+    // Current batch, shared with the workers
+    const uint8_t* actions;
+    float* observations;
+    float* rewards;
+    uint8_t* dones;
+
+    // Thread pool, the calling thread runs the first chunk itself
+    int threadCount;
+    std::thread* threads;
+    std::mutex mutex;
+    std::condition_variable startCond, doneCond;
+    unsigned int generation;
+    int pending;
+    bool quit;
+};
+
+static void resetGame(struct Env* env, int i) {
+    struct Game* game = &env->games[i];
+
+    // Chain episode seeds through the game's own RNG
+    gameInit(game, game->seed ^ (i * 0x9e3779b9));
+    gameJoin(game);
+    env->steps[i] = 0;
+}
+
+static void observe(const struct Game* game, float* obs) {
+
+    const struct Survivor* survivor = &game->survivors[0];
+    obs[0] = survivor->x / SCREEN_WIDTH;
+    obs[1] = survivor->y / SCREEN_HEIGHT;
+    obs[2] = survivor->vX / survivor->speed;
+    obs[3] = survivor->vY / survivor->jumpSpeed;
+    obs[4] = survivor->scaleX;
+    obs[5] = survivor->state;
+    obs += ENV_SURVIVOR_OBS;
+
+    // Zombies relative to the survivor
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        const struct Zombie* zombie = &game->zombies[i];
+        if (zombie->alive) {
+            obs[0] = 1;
+            obs[1] = (zombie->x - survivor->x) / SCREEN_WIDTH;
+            obs[2] = (zombie->y - survivor->y) / SCREEN_HEIGHT;
+            obs[3] = zombie->dir;
+            obs[4] = zombie->state;
+        } else {
+            obs[0] = obs[1] = obs[2] = obs[3] = obs[4] = 0;
+        }
+        obs += ENV_ZOMBIE_OBS;
+    }
+}
+
+static void stepRange(struct Env* env, int first, int last) {
+
+    uint8_t inputs[MAX_SURVIVORS] = { 0 };
+
+    for (int i = first; i < last; i++) {
+        struct Game* game = &env->games[i];
+        int kills = game->kills;
+
+        inputs[0] = env->actions[i];
+        gameUpdate(game, inputs);
+        env->steps[i]++;
+
+        bool dead = game->survivors[0].state == STATE_DEAD;
+        env->rewards[i] = (game->kills - kills) + (dead ? DEATH_REWARD : 0);
+        env->dones[i] = dead || (env->maxSteps > 0 && env->steps[i] >= env->maxSteps);
+
+        if (env->dones[i]) {
+            resetGame(env, i);
+        }
+
+        observe(game, env->observations + (size_t)i * ENV_OBS_SIZE);
+    }
+}
+
+// Contiguous chunk of games for one thread
+static void chunk(struct Env* env, int thread, int* first, int* last) {
+    *first = (int)((long long)env->count * thread / env->threadCount);
+    *last = (int)((long long)env->count * (thread + 1) / env->threadCount);
+}
+
+static void worker(struct Env* env, int thread) {
+
+    unsigned int seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(env->mutex);
+            env->startCond.wait(lock, [&] { return env->quit || env->generation != seen; });
+            if (env->quit) {
+                return;
+            }
+            seen = env->generation;
+        }
+
+        int first, last;
+        chunk(env, thread, &first, &last);
+        stepRange(env, first, last);
+
+        std::lock_guard<std::mutex> lock(env->mutex);
+        if (--env->pending == 0) {
+            env->doneCond.notify_one();
+        }
+    }
+}
+
+Env* envCreate(int count, int threads, uint32_t seed, int maxSteps) {
+
+    if (count <= 0) {
+        return NULL;
+    }
+
+    if (threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads <= 0) {
+        threads = 1;
+    }
+    if (threads > count) {
+        threads = count;
+    }
+
+    // Nothing may throw across the C interface, allocation failures return NULL
+    struct Env* env = new (std::nothrow) Env();
+    if (env == NULL) {
+        return NULL;
+    }
+    env->count = count;
+    env->maxSteps = maxSteps;
+    env->games = new (std::nothrow) Game[count];
+    env->steps = new (std::nothrow) int[count];
+    if (env->games == NULL || env->steps == NULL) {
+        delete[] env->steps;
+        delete[] env->games;
+        delete env;
+        return NULL;
+    }
+    env->threadCount = threads;
+    env->generation = 0;
+    env->pending = 0;
+    env->quit = false;
+
+    for (int i = 0; i < count; i++) {
+        gameInit(&env->games[i], seed + i * 7919);
+        resetGame(env, i);
+    }
+
+    // Without the pool every step just runs on the calling thread
+    env->threads = new (std::nothrow) std::thread[threads - 1];
+    if (env->threads == NULL) {
+        env->threadCount = 1;
+    }
+    for (int i = 1; i < env->threadCount; i++) {
+        try {
+            env->threads[i - 1] = std::thread(worker, env, i);
+        } catch (const std::system_error&) {
+            env->threadCount = i;
+        }
+    }
+
+    return env;
+}
+
+void envDestroy(Env* env) {
+
+    if (env == NULL) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(env->mutex);
+        env->quit = true;
+    }
+    env->startCond.notify_all();
+
+    for (int i = 0; i < env->threadCount - 1; i++) {
+        env->threads[i].join();
+    }
+
+    delete[] env->threads;
+    delete[] env->steps;
+    delete[] env->games;
+    delete env;
+}
+
+int envCount(const Env* env) {
+    return env->count;
+}
+
+int envObservationSize(void) {
+    return ENV_OBS_SIZE;
+}
+
+void envReset(Env* env, float* observations) {
+    for (int i = 0; i < env->count; i++) {
+        resetGame(env, i);
+        observe(&env->games[i], observations + (size_t)i * ENV_OBS_SIZE);
+    }
+}
+
+void envStep(Env* env, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones) {
+
+    env->actions = actions;
+    env->observations = observations;
+    env->rewards = rewards;
+    env->dones = dones;
+
+    if (env->threadCount > 1) {
+        std::lock_guard<std::mutex> lock(env->mutex);
+        env->pending = env->threadCount - 1;
+        env->generation++;
+    }
+    env->startCond.notify_all();
+
+    int first, last;
+    chunk(env, 0, &first, &last);
+    stepRange(env, first, last);
+
+    if (env->threadCount > 1) {
+        std::unique_lock<std::mutex> lock(env->mutex);
+        env->doneCond.wait(lock, [&] { return env->pending == 0; });
+    }
+}
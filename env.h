@@ -0,0 +1,38 @@
+#ifndef ENV_H
+#define ENV_H
+
+// Batch environment: steps many independent games in lockstep across a
+// thread pool, for training and load testing bots. Plain C interface so it
+// can be loaded from any language (make env builds libzombies_env.so).
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Env Env;
+
+// Observation floats per game: the survivor, then every zombie slot
+#define ENV_SURVIVOR_OBS 6
+#define ENV_ZOMBIE_OBS 5
+
+// Creates count games, threads 0 uses every core, maxSteps 0 never truncates
+Env* envCreate(int count, int threads, uint32_t seed, int maxSteps);
+void envDestroy(Env* env);
+
+int envCount(const Env* env);
+int envObservationSize(void);
+
+// Restarts every game and writes count * envObservationSize() floats
+void envReset(Env* env, float* observations);
+
+// Advances every game by one tick. actions holds one INPUT_* mask per game.
+// Finished games restart on their own, their observation is the new episode's first.
+void envStep(Env* env, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
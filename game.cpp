@@ -0,0 +1,541 @@
+#include "game.h"
+
+struct World world;
+int zombieAnimSpeed = 8;
+int zombieSpeed = 3;
+int bulletSpeed = 20;
+
+// Utils
+static int randInRange(struct Game* game, int min, int max) {
+
+    // Each game owns its sequence so the simulation is reproducible
+    return xorshift32(&game->seed) % (max + 1 - min) + min;
+}
+
+static void pushEvent(struct Game* game, EventType type, int source, float x, float y, int dir) {
+    if (game->eventCount < EVENT_COUNT) {
+        struct Event* event = &game->events[game->eventCount++];
+        event->type = type;
+        event->source = source;
+        event->x = x;
+        event->y = y;
+        event->dir = dir;
+    }
+}
+
+static bool collision(float xA, float xB, float yA, float yB, int wA, int wB, int hA, int hB) {
+    if (yA + hA <= yB) {
+        return false;
+    }
+
+    if (yA >= yB + hB) {
+        return false;
+    }
+
+    if (xA + wA <= xB) {
+        return false;
+    }
+
+    if (xA >= xB + wB) {
+        return false;
+    }
+
+    return true;
+}
+
+// Time of impact in [0, 1] of box A moving by (dx, dy) against box B,
+// -1 if they never overlap during the move
+static float sweptCollision(float xA, float xB, float yA, float yB, int wA, int wB, int hA, int hB, float dx, float dy) {
+
+    float entry = -1e30f, exit = 1e30f;
+
+    // Slab test on each axis, a still axis has to overlap already
+    if (dx == 0) {
+        if (xA + wA <= xB || xA >= xB + wB) {
+            return -1;
+        }
+    } else {
+        float near = dx > 0 ? (xB - (xA + wA)) / dx : (xB + wB - xA) / dx;
+        float far = dx > 0 ? (xB + wB - xA) / dx : (xB - (xA + wA)) / dx;
+        entry = near > entry ? near : entry;
+        exit = far < exit ? far : exit;
+    }
+
+    if (dy == 0) {
+        if (yA + hA <= yB || yA >= yB + hB) {
+            return -1;
+        }
+    } else {
+        float near = dy > 0 ? (yB - (yA + hA)) / dy : (yB + hB - yA) / dy;
+        float far = dy > 0 ? (yB + hB - yA) / dy : (yB - (yA + hA)) / dy;
+        entry = near > entry ? near : entry;
+        exit = far < exit ? far : exit;
+    }
+
+    if (entry >= exit || entry > 1 || exit <= 0) {
+        return -1;
+    }
+
+    return entry > 0 ? entry : 0;
+}
+
+// Landing on the platform top while moving from (prevX, prevY) to (x, y).
+// Swept, so fast falls and lower tick rates cannot step over the surface.
+static bool platformCollision(float prevX, float prevY, float x, float y, int w, int h) {
+
+    float prevBottom = prevY + h;
+    float bottom = y + h;
+    if (prevBottom > platform.y || bottom <= platform.y) {
+        return false;
+    }
+
+    // Horizontal position when the feet reach the surface
+    float t = (platform.y - prevBottom) / (bottom - prevBottom);
+    float contactX = prevX + (x - prevX) * t;
+
+    return contactX + 48 >= platform.x &&
+        contactX + w - 48 <= platform.x + platform.w;
+}
+
+// Closest living survivor, -1 if nobody is alive
+static int nearestSurvivor(struct Game* game, float x) {
+
+    int nearest = -1;
+    float best = 0;
+
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        struct Survivor* survivor = &game->survivors[i];
+        if (!survivor->active || survivor->state == STATE_DEAD) {
+            continue;
+        }
+
+        float dist = survivor->x > x ? survivor->x - x : x - survivor->x;
+        if (nearest == -1 || dist < best) {
+            nearest = i;
+            best = dist;
+        }
+    }
+
+    return nearest;
+}
+
+static void spawnZombie(struct Game* game) {
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        struct Zombie* zombie = &game->zombies[i];
+        if (!zombie->alive) {
+            zombie->frameX = 0;
+            zombie->frameY = 0;
+            zombie->x = randInRange(game, platform.x, platform.x + platform.w - zombie->w);
+
+            int target = nearestSurvivor(game, zombie->x);
+            float targetX = target == -1 ? SCREEN_WIDTH / 2 : game->survivors[target].x;
+            zombie->dir = targetX - zombie->x > 0 ? 1 : -1;
+
+            zombie->y = 0;
+            zombie->vX = 0;
+            zombie->vY = 0;
+            zombie->alive = true;
+            zombie->state = STATE_FALL;
+            return;
+        }
+    }
+}
+
+static void shootBullet(struct Game* game, struct Survivor* survivor) {
+
+    for (int i = 0; i < BULLET_COUNT; i++) {
+        struct Bullet* bullet = &game->bullets[i];
+        if (!bullet->alive) {
+            if (survivor->scaleX == 1) {
+                bullet->x = survivor->x + 48;
+            } else {
+                bullet->x = survivor->x + 16;
+            }
+
+            bullet->y = survivor->y + 32;
+            bullet->dir = survivor->scaleX;
+            bullet->owner = (int)(survivor - game->survivors);
+            bullet->alive = true;
+            return;
+        }
+    }
+}
+
+// Tests the whole path the bullet travelled this tick, not just where it ended up,
+// and only the first zombie along that path takes the bullet
+static void hitZombies(struct Game* game, struct Bullet* bullet, float prevX, float x) {
+
+    int first = -1;
+    float firstTime = 2;
+
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        struct Zombie* zombie = &game->zombies[i];
+        if (!zombie->alive) {
+            continue;
+        }
+
+        float time = sweptCollision(prevX, zombie->x, bullet->y, zombie->y, bullet->w, zombie->w, bullet->h, zombie->h, x - prevX, 0);
+        if (time >= 0 && time < firstTime) {
+            first = i;
+            firstTime = time;
+        }
+    }
+
+    if (first != -1) {
+        struct Zombie* zombie = &game->zombies[first];
+        zombie->vX = bullet->dir * 10;
+        zombie->state = STATE_HIT;
+        bullet->alive = false;
+        pushEvent(game, EVENT_HIT, bullet->owner, zombie->x + zombie->w / 2, bullet->y, bullet->dir);
+    }
+}
+
+static void stabZombies(struct Game* game, struct Survivor* survivor) {
+
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        struct Zombie* zombie = &game->zombies[i];
+        if (zombie->alive && collision(survivor->x, zombie->x, survivor->y, zombie->y, survivor->w, zombie->w, survivor->h, zombie->h)) {
+            zombie->vY = -15;
+            zombie->vX = survivor->scaleX * 5;
+            zombie->state = STATE_HIT;
+            pushEvent(game, EVENT_STAB, (int)(survivor - game->survivors), zombie->x + zombie->w / 2, zombie->y + zombie->h / 2, survivor->scaleX);
+        }
+    }
+}
+
+// Restart survivor
+static void restart(struct Game* game, struct Survivor* survivor) {
+
+    // The round is over once nobody else is left standing
+    bool roundOver = nearestSurvivor(game, survivor->x) == -1;
+
+    survivor->x = 200;
+    survivor->y = 100;
+    survivor->w = SPRITE_SIZE;
+    survivor->h = SPRITE_SIZE;
+    survivor->vX = 0;
+    survivor->vY = 0;
+    survivor->scaleX = 1;
+    survivor->scaleY = 1;
+    survivor->frameX = 0;
+    survivor->frameY = 0;
+    survivor->alive = true;
+    survivor->animCompleted = false;
+    survivor->state = STATE_IDLE;
+
+    if (!roundOver) {
+        return;
+    }
+
+    game->score = 0;
+
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        game->zombies[i].alive = false;
+    }
+}
+
+void gameInit(struct Game* game, uint32_t seed) {
+    *game = Game();
+    game->score = 0;
+    game->kills = 0;
+    game->tick = 0;
+    game->lastSpawnTick = 0;
+    game->eventCount = 0;
+
+    // xorshift must never be seeded with zero
+    game->seed = seed != 0 ? seed : 0x9e3779b9;
+}
+
+int gameJoin(struct Game* game) {
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        struct Survivor* survivor = &game->survivors[i];
+        if (!survivor->active) {
+            restart(game, survivor);
+            survivor->active = true;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void gameLeave(struct Game* game, int slot) {
+    game->survivors[slot].active = false;
+    game->survivors[slot].alive = false;
+    game->survivors[slot].state = STATE_DEAD;
+}
+
+static void updateSurvivor(struct Game* game, struct Survivor* survivor, uint8_t input) {
+
+    // Restart game
+    if (survivor->state == STATE_DEAD) {
+        if (input & INPUT_RESTART) {
+            restart(game, survivor);
+        }
+    }
+    // Out of screen
+    if (survivor->y > SCREEN_HEIGHT && survivor->state != STATE_DEAD) {
+        survivor->state = STATE_DEAD;
+        survivor->alive = false;
+    }
+
+    if (survivor->state != STATE_DEAD) {
+
+        float prevX = survivor->x, prevY = survivor->y;
+
+        // Apply gravity
+        survivor->vY += world.gravity;
+        survivor->y += survivor->vY;
+
+        // Motion
+        survivor->x += survivor->vX;
+
+        // Platform collision
+        if (platformCollision(prevX, prevY, survivor->x, survivor->y, survivor->w, survivor->h)) {
+
+            survivor->y = platform.y - survivor->h;
+            survivor->vY = 0;
+
+            if (survivor->state == STATE_FALL || survivor->state == STATE_JUMP) {
+                survivor->frameY = 0;
+                survivor->state = STATE_IDLE;
+            }
+
+        } else if (survivor->state != STATE_JUMP) {
+            survivor->state = STATE_FALL;
+        }
+
+        // Input processing
+        if (survivor->state != STATE_SHOOT && survivor->state != STATE_STAB && survivor->state != STATE_FALL) {
+
+            if (survivor->state == STATE_JUMP) {
+
+                if (input & INPUT_RIGHT) {
+                    survivor->vX = survivor->speed;
+                    survivor->scaleX = 1;
+                } else if (input & INPUT_LEFT) {
+                    survivor->vX = -survivor->speed;
+                    survivor->scaleX = -1;
+                } else {
+                    survivor->vX = 0;
+                }
+
+            } else {
+
+                if (input & INPUT_JUMP) {
+                    survivor->vY = -survivor->jumpSpeed;
+                    survivor->frameY = 3;
+                    survivor->state = STATE_JUMP;
+                } else if (input & INPUT_SHOOT) {
+                    survivor->frameX = 0;
+                    survivor->frameY = 2;
+                    survivor->vX = 0;
+                    survivor->animCompleted = false;
+                    survivor->shot = false;
+                    survivor->state = STATE_SHOOT;
+                } else if (input & INPUT_STAB) {
+                    survivor->frameX = 0;
+                    survivor->frameY = 5;
+                    survivor->vX = 0;
+                    survivor->animCompleted = false;
+                    survivor->stab = false;
+                    survivor->state = STATE_STAB;
+                } else if (input & INPUT_RIGHT) {
+                    survivor->vX = survivor->speed;
+                    survivor->scaleX = 1;
+                    survivor->frameY = 1;
+                    survivor->state = STATE_WALK;
+                } else if (input & INPUT_LEFT) {
+                    survivor->vX = -survivor->speed;
+                    survivor->scaleX = -1;
+                    survivor->frameY = 1;
+                    survivor->state = STATE_WALK;
+                } else {
+                    survivor->frameY = 0;
+                    survivor->vX = 0;
+                    survivor->state = STATE_IDLE;
+                }
+            }
+        }
+
+        // Player states
+        if (survivor->state == STATE_SHOOT) {
+
+            if (survivor->frameX / survivor->animSpeed == 2 && !survivor->shot) {
+                survivor->shot = true;
+                shootBullet(game, survivor);
+            }
+
+            if (survivor->animCompleted) {
+                survivor->frameY = 0;
+                survivor->state = STATE_IDLE;
+            }
+        }
+
+        if (survivor->state == STATE_STAB) {
+
+            if (survivor->frameX / survivor->animSpeed == 2 && !survivor->stab) {
+                survivor->stab = true;
+                stabZombies(game, survivor);
+            }
+
+            if (survivor->animCompleted) {
+                survivor->frameY = 0;
+                survivor->state = STATE_IDLE;
+            }
+        }
+    } else { // state dead
+        if (survivor->animCompleted) {
+            survivor->alive = false;
+        }
+    }
+}
+
+static void updateZombie(struct Game* game, struct Zombie* zombie) {
+
+    // Out of screen
+    if (zombie->y > SCREEN_HEIGHT) {
+        zombie->alive = false;
+        game->score += 10;
+        if (zombie->state == STATE_HIT) {
+            game->kills++;
+        }
+        pushEvent(game, EVENT_DEATH, -1, zombie->x + zombie->w / 2, SCREEN_HEIGHT, zombie->dir);
+    }
+
+    float prevX = zombie->x, prevY = zombie->y;
+
+    // Apply gravity
+    zombie->vY += world.gravity;
+    zombie->y += zombie->vY;
+
+    // Motion
+    zombie->x += zombie->vX;
+
+    // Platform
+    if (zombie->state == STATE_HIT) {
+        return;
+    }
+
+    if (platformCollision(prevX, prevY, zombie->x, zombie->y, zombie->w, zombie->h)) {
+        zombie->y = platform.y - zombie->h;
+        zombie->vY = 0;
+
+        if (zombie->state == STATE_FALL) {
+            zombie->state = STATE_WALK;
+        }
+    } else {
+        zombie->vX = 0;
+        zombie->state = STATE_FALL;
+    }
+
+    if (zombie->state == STATE_WALK) {
+
+        // Move
+        zombie->vX = zombieSpeed * zombie->dir;
+
+        // Attack a survivor if colliding
+        for (int i = 0; i < MAX_SURVIVORS; i++) {
+            struct Survivor* survivor = &game->survivors[i];
+            if (survivor->active && survivor->state != STATE_DEAD && collision(zombie->x, survivor->x, zombie->y, survivor->y, zombie->w, survivor->w, zombie->h, survivor->h)) {
+                zombie->frameX = 0;
+                zombie->frameY = 2;
+                zombie->vX = 0;
+                zombie->target = i;
+                zombie->attack = false;
+                zombie->animCompleted = false;
+                zombie->state = STATE_ATTACK;
+                break;
+            }
+        }
+    }
+
+    if (zombie->state == STATE_ATTACK) {
+
+        // Attack survivor
+        struct Survivor* survivor = &game->survivors[zombie->target];
+        if (zombie->frameX / zombieAnimSpeed == 3 && !zombie->attack && survivor->active && survivor->state != STATE_JUMP && survivor->state != STATE_DEAD) {
+            zombie->attack = true;
+            survivor->frameX = 0;
+            survivor->frameY = 4;
+            survivor->vX = survivor->vY = 0;
+            survivor->animCompleted = false;
+            survivor->state = STATE_DEAD;
+        }
+
+        if (zombie->animCompleted) {
+            zombie->frameX = 0;
+            zombie->frameY = 0;
+            zombie->state = STATE_WALK;
+        }
+    }
+}
+
+// Game logic
+void gameUpdate(struct Game* game, const uint8_t inputs[MAX_SURVIVORS]) {
+
+    game->tick++;
+    game->eventCount = 0;
+
+    // Survivors
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        if (game->survivors[i].active) {
+            updateSurvivor(game, &game->survivors[i], inputs[i]);
+        }
+    }
+
+    // Zombies
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        if (game->zombies[i].alive) {
+            updateZombie(game, &game->zombies[i]);
+        }
+    }
+
+    // Spawn zombie every N seconds
+    if (game->tick > game->lastSpawnTick + SPAWN_FREQ * TICK_RATE) {
+        spawnZombie(game);
+        game->lastSpawnTick = game->tick;
+    }
+
+    // Bullets
+    for (int i = 0; i < BULLET_COUNT; i++) {
+        struct Bullet* bullet = &game->bullets[i];
+        if (bullet->alive) {
+            float prevX = bullet->x;
+            bullet->x += bulletSpeed * bullet->dir;
+
+            // Hit zombie, only along the part of the path that is still on screen
+            float x = bullet->x;
+            if (x < -bullet->w) {
+                x = -bullet->w;
+            } else if (x > SCREEN_WIDTH) {
+                x = SCREEN_WIDTH;
+            }
+            hitZombies(game, bullet, prevX, x);
+
+            // Out of screen
+            if (bullet->x + bullet->w < 0 || bullet->x > SCREEN_WIDTH) {
+                bullet->alive = false;
+            }
+        }
+    }
+
+    // Update frames
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        struct Survivor* survivor = &game->survivors[i];
+        survivor->frameX++;
+        if (survivor->frameX / survivor->animSpeed >= 4) {
+            survivor->animCompleted = true;
+            survivor->frameX = 0;
+        }
+    }
+
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        struct Zombie* zombie = &game->zombies[i];
+        zombie->frameX++;
+        if (zombie->alive && zombie->frameX / zombieAnimSpeed >= 4) {
+            zombie->animCompleted = true;
+            zombie->frameX = 0;
+        }
+    }
+}
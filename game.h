@@ -0,0 +1,162 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdint.h>
+
+// Screen dimension constants
+const int SCREEN_WIDTH = 512;
+const int SCREEN_HEIGHT = 400;
+
+// Simulation steps per second
+const int TICK_RATE = 60;
+
+const int MAX_SURVIVORS = 4;
+const int ZOMBIE_COUNT = 20;
+const int BULLET_COUNT = 10 * MAX_SURVIVORS;
+const int SPAWN_FREQ = 3;
+
+// Gameplay events kept per tick for visual effects
+const int EVENT_COUNT = 32;
+
+// Sprite sizes (match the assets, the simulation runs without textures)
+const int SPRITE_SIZE = 64;
+const int BULLET_W = 16;
+const int BULLET_H = 2;
+const int PLATFORM_W = 256;
+const int PLATFORM_H = 8;
+
+// Input buttons, one bit each
+enum {
+    INPUT_LEFT = 1 << 0,
+    INPUT_RIGHT = 1 << 1,
+    INPUT_JUMP = 1 << 2,
+    INPUT_SHOOT = 1 << 3,
+    INPUT_STAB = 1 << 4,
+    INPUT_RESTART = 1 << 5
+};
+
+enum State {
+    STATE_IDLE,
+    STATE_WALK,
+    STATE_JUMP,
+    STATE_FALL,
+    STATE_SHOOT,
+    STATE_STAB,
+    STATE_HIT,
+    STATE_ATTACK,
+    STATE_DEAD
+};
+
+enum EventType {
+    EVENT_HIT,
+    EVENT_STAB,
+    EVENT_DEATH
+};
+
+// Game objects
+struct Platform {
+    int x, y, w, h;
+};
+
+const struct Platform platform = { (SCREEN_WIDTH / 2) - (PLATFORM_W / 2), 300, PLATFORM_W, PLATFORM_H };
+
+struct Survivor {
+    float x, y;
+    int w, h;
+    float vX, vY;
+    int scaleX, scaleY;
+    int frameX, frameY;
+    int animSpeed = 5;
+    int speed = 3, jumpSpeed = 10;
+    bool animCompleted = false;
+    bool shot = false;
+    bool stab = false;
+    bool alive = false;
+    bool active = false;
+    State state;
+};
+
+struct Zombie {
+    float x, y;
+    int w = 64;
+    int h = 64;
+    float vX, vY;
+    int dir;
+    int target;
+    int frameX, frameY;
+    bool animCompleted = false;
+    bool attack = false;
+    bool alive = false;
+    State state;
+};
+
+struct Bullet {
+    float x, y;
+    int w = BULLET_W;
+    int h = BULLET_H;
+    int dir = 1;
+    int owner = 0;
+    bool alive = false;
+};
+
+// source is the survivor slot that caused the event, -1 for none
+struct Event {
+    EventType type;
+    int source;
+    float x, y;
+    int dir;
+};
+
+// World
+struct World {
+    float gravity = 0.5f;
+};
+
+// One independent game: every survivor, zombie and bullet plus its own RNG.
+// Plain data, so it can be copied for prediction and rollback.
+struct Game {
+    struct Survivor survivors[MAX_SURVIVORS];
+    struct Zombie zombies[ZOMBIE_COUNT];
+    struct Bullet bullets[BULLET_COUNT];
+    int score;
+
+    // Zombies knocked off by a survivor, unlike score this skips the ones
+    // that walk off the ledge by themselves. Kept across restarts.
+    int kills;
+    unsigned int tick;
+    unsigned int lastSpawnTick;
+    uint32_t seed;
+
+    // What happened during the last tick
+    struct Event events[EVENT_COUNT];
+    int eventCount;
+};
+
+// Advances a xorshift32 sequence, the state must never be zero
+inline uint32_t xorshift32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+extern struct World world;
+extern int zombieAnimSpeed;
+extern int zombieSpeed;
+extern int bulletSpeed;
+
+// Resets the game to an empty world
+void gameInit(struct Game* game, uint32_t seed);
+
+// Places a new survivor in the first free slot, returns the slot or -1 if full
+int gameJoin(struct Game* game);
+
+// Removes the survivor in the given slot
+void gameLeave(struct Game* game, int slot);
+
+// Advances the game by one tick, inputs holds one INPUT_* mask per survivor slot
+void gameUpdate(struct Game* game, const uint8_t inputs[MAX_SURVIVORS]);
+
+#endif
@@ -4,12 +4,17 @@
 #include <SDL2/SDL_ttf.h>
 #include <stdio.h>
 #include <string>
+#include <string.h>
 #include <stdlib.h>
 #include <time.h>
-
-// Screen dimension constants
-const int SCREEN_WIDTH = 512;
-const int SCREEN_HEIGHT = 400;
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "game.h"
+#include "client.h"
+#include "alloc.h"
+#include "particles.h"
+#include "snapshot.h"
 
 // Starts up SDL and creates window
 bool init();
@@ -32,225 +37,142 @@ SDL_Renderer* gRenderer = NULL;
 // Font
 TTF_Font* gFont = NULL;
 
-// Score
-int score = 0;
-SDL_Texture* scoreTexture;
-int scoreWidth, scoreHeight;
+// Text, one texture per printable character so drawing text never allocates
+const char GLYPH_FIRST = ' ';
+const char GLYPH_LAST = '~';
+struct Glyph {
+    SDL_Texture* texture;
+    int w, h;
+};
+struct Glyph glyphs[GLYPH_LAST - GLYPH_FIRST + 1];
 
-// Data to save (enough for the high score)
+// Data to save (enough for the high score), written once on quit
 Sint32 highScore;
+bool highScoreChanged = false;
 
-// Game objects
+// Background
 struct Background {
     int x, y, w, h;
     SDL_Texture* texture;
 };
 
-struct Platform {
-    int x, y, w, h;
-    SDL_Texture* texture;
-};
-
-struct Survivor {
-    float x, y;
-    int w, h;
-    float vX, vY;
-    int scaleX, scaleY;
-    int frameX, frameY;
-    int animSpeed = 5;
-    int speed = 3, jumpSpeed = 10;
-    bool animCompleted = false;
-    bool shot = false;
-    bool stab = false;
-    bool alive = true;
-    std::string state;
-    SDL_Texture* texture;
-};
+struct Background background;
 
-const int ZOMBIE_COUNT = 20;
-const int SPAWN_FREQ = 3;
-unsigned int lastSpawnTime = 0, currentTime;
-int zombieAnimSpeed = 8;
-int zombieSpeed = 3;
+// Textures
+SDL_Texture* platformTexture;
+SDL_Texture* survivorTexture;
 SDL_Texture* zombieTexture;
-struct Zombie {
-    float x, y;
-    int w = 64;
-    int h = 64;
-    float vX, vY;
-    int dir;
-    int frameX, frameY;
-    bool animCompleted = false;
-    bool attack = false;
-    bool alive = false;
-    std::string state;
-};
-
-const int BULLET_COUNT = 10;
 SDL_Texture* bulletTexture;
-int bulletSpeed = 20;
-struct Bullet {
-    float x, y;
-    int w, h;
-    int dir = 1;
-    bool alive = false;
-};
 
-struct Background background;
-struct Platform platform;
-struct Survivor survivor;
-struct Bullet bullets[BULLET_COUNT];
-struct Zombie zombies[ZOMBIE_COUNT];
-
-// World
-struct World {
-    float gravity = 0.5f;
-};
+// The simulation, or in online mode the view rebuilt from snapshots
+struct Game game;
+int localSlot = 0;
 
-struct World world;
+// Online mode
+bool online = false;
+struct NetClient client;
 
-// Utils
-bool renderScoreText(std::string textureText, SDL_Color textColor) {
-    
-    // Free old texture
-    SDL_DestroyTexture(scoreTexture);
-
-    SDL_Surface* textSurface = TTF_RenderText_Solid(gFont, textureText.c_str(), textColor);
-    if (textSurface == NULL) {
-        printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
-    } else {
-        scoreTexture = SDL_CreateTextureFromSurface(gRenderer, textSurface);
-        if (scoreTexture == NULL) {
-            printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
-        } else {
-            scoreWidth = textSurface->w;
-            scoreHeight = textSurface->h;
-        }
+// Hit, stab and death effects
+struct Particles particles;
 
-        SDL_FreeSurface(textSurface);
-    }
+// The simulation runs on its own thread at TICK_RATE and hands finished
+// frames to the main thread, so a slow present never holds up game logic
+struct TripleBuffer snapshots;
+std::atomic<uint8_t> gInput{ 0 };
+std::atomic<bool> simRunning{ false };
+std::atomic<unsigned int> tickCount{ 0 };
 
-    return scoreTexture != NULL;
-}
+// Most ticks run back to back after the simulation thread was held up
+const int MAX_CATCHUP_TICKS = 5;
 
-int randInRange(int min, int max) {
-    return rand() % (max + 1 - min) + min;
-}
+// Per-frame scratch memory, big enough for the vertices of every particle
+const size_t FRAME_ARENA_SIZE = 16 << 20;
+struct FrameArena gFrameArena;
 
-void spawnZombie() {
-    for (int i = 0; i < ZOMBIE_COUNT; i++) {
-        if (!zombies[i].alive) {
-            zombies[i].frameX = 0;
-            zombies[i].frameY = 0;
-            zombies[i].x = randInRange(platform.x, platform.x + platform.w - zombies[i].w);
-            zombies[i].dir = survivor.x - zombies[i].x > 0 ? 1 : -1;
-            zombies[i].y = 0;
-            zombies[i].alive = true;
-            zombies[i].state = "state_fall";
-            return;
-        }
-    }
-}
+// Allocation tracking: --alloc-report prints allocations per frame every second,
+// --alloc-test plays with scripted input and fails if a frame allocates after warmup
+const int ALLOC_WARMUP = 120;
+const int ALLOC_TEST_TICKS = 60 * 60;
+bool allocReport = false;
+bool allocTest = false;
+int frameCount = 0;
 
-void shootBullet() {
+// Utils
+bool loadGlyphs(SDL_Color textColor) {
 
-    for (int i = 0; i < BULLET_COUNT; i++) {
-        if (!bullets[i].alive) {
-            if (survivor.scaleX == 1) {
-                bullets[i].x = survivor.x + 48;
-            } else {
-                bullets[i].x = survivor.x + 16;
-            }
+    char text[2] = { 0, 0 };
 
-            bullets[i].y = survivor.y + 32;
-            bullets[i].dir = survivor.scaleX;
-            bullets[i].alive = true;
-            return;
-        }
-    }
-}
+    for (char c = GLYPH_FIRST; c <= GLYPH_LAST; c++) {
+        struct Glyph* glyph = &glyphs[c - GLYPH_FIRST];
+        text[0] = c;
 
-bool collision(float xA, float xB, float yA, float yB, int wA, int wB, int hA, int hB) {
-    if (yA + hA <= yB) {
-        return false;
-    }
+        SDL_Surface* textSurface = TTF_RenderText_Solid(gFont, text, textColor);
+        if (textSurface == NULL) {
 
-    if (yA >= yB + hB) {
-        return false;
-    }
+            // Blank characters may have no pixels, keep their width
+            TTF_SizeText(gFont, text, &glyph->w, &glyph->h);
+            glyph->texture = NULL;
+            continue;
+        }
+        allocTrackSurface();
 
-    if (xA + wA <= xB) {
-        return false;
-    }
+        glyph->texture = SDL_CreateTextureFromSurface(gRenderer, textSurface);
+        if (glyph->texture == NULL) {
+            printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
+            SDL_FreeSurface(textSurface);
+            return false;
+        }
+        allocTrackTexture();
 
-    if (xA >= xB + wB) {
-        return false;
+        glyph->w = textSurface->w;
+        glyph->h = textSurface->h;
+        SDL_FreeSurface(textSurface);
     }
 
     return true;
 }
 
-void hitZombies(struct Bullet *bullet) {
-
-    for (int i = 0; i < ZOMBIE_COUNT; i++) {
-        if (zombies[i].alive && collision(bullet->x, zombies[i].x, bullet->y, zombies[i].y, bullet->w, zombies[i].w, bullet->h, zombies[i].h)) {
-            zombies[i].vX = bullet->dir * 10;
-            zombies[i].state = "state_hit";
-            bullet->alive = false;
+void renderText(const char* text, int x, int y) {
+    for (; *text != '\0'; text++) {
+        if (*text < GLYPH_FIRST || *text > GLYPH_LAST) {
+            continue;
         }
-    }
-}
-
-void stabZombies() {
 
-    for (int i = 0; i < ZOMBIE_COUNT; i++) {
-        if (zombies[i].alive && collision(survivor.x, zombies[i].x, survivor.y, zombies[i].y, survivor.w, zombies[i].w, survivor.h, zombies[i].h)) {
-            zombies[i].vY = -15;
-            zombies[i].vX = survivor.scaleX * 5;
-            zombies[i].state = "state_hit";
+        struct Glyph* glyph = &glyphs[*text - GLYPH_FIRST];
+        if (glyph->texture != NULL) {
+            SDL_Rect dstGlyph = { .x = x, .y = y, .w = glyph->w, .h = glyph->h };
+            SDL_RenderCopy(gRenderer, glyph->texture, NULL, &dstGlyph);
         }
+        x += glyph->w;
     }
 }
 
-bool platformCollision(float x, float y, int w, int h) {
-    return y + h > platform.y &&
-        x + 48 >= platform.x &&
-        x + w - 48 <= platform.x + platform.w;
-}
-
-// Restart game
-void restart() {
-    survivor.x = 200;
-    survivor.y = 100;
-    survivor.vX = 0;
-    survivor.vY = 0;
-    survivor.scaleX = 1;
-    survivor.frameX = 0;
-    survivor.frameY = 0;
-    survivor.alive = true;
-    survivor.animCompleted = false;
-    survivor.state = "state_idle";
-
-    score = 0;
+// Update high score, file I/O stays out of the frame loop
+void updateHighScore() {
 
-    for (int i = 0; i < ZOMBIE_COUNT; i++) {
-        zombies[i].alive = false;
+    if (game.score < highScore) {
+        return;
     }
 
+    highScore = game.score;
+    highScoreChanged = true;
 }
 
 // Save high score
 void saveHighScore() {
 
-    if (score < highScore) {
+    if (!highScoreChanged) {
         return;
     }
 
-    highScore = score;
-
     SDL_RWops* file = SDL_RWFromFile("score.bin", "w+b");
+    if (file == NULL) {
+        printf("Unable to save high score! SDL Error: %s\n", SDL_GetError());
+        return;
+    }
     SDL_RWwrite(file, &highScore, sizeof(Sint32), 1);
     SDL_RWclose(file);
+    highScoreChanged = false;
 }
 
 
@@ -282,6 +204,9 @@ bool init() {
                 // Init renderer color
                 SDL_SetRenderDrawColor(gRenderer, 0xdf, 0xda, 0xd2, 0xff);
 
+                // Particles fade out through their vertex alpha
+                SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+
                 // Init png loading
                 int imgFlags = IMG_INIT_PNG;
                 if (!(IMG_Init(imgFlags) & imgFlags)) {
@@ -306,13 +231,29 @@ bool loadMedia() {
     // Loading success flag
     bool success = true;
     
-    // Seed random number generator
-    srand(time(NULL));
+    // Init local game, seeded from the clock
+    if (!online) {
+        gameInit(&game, time(NULL));
+        localSlot = gameJoin(&game);
+    }
 
     // Init font
     gFont = TTF_OpenFont("assets/3Dventure.ttf", 28);
     if (gFont == NULL) {
         printf("Failed to load font! SDL_ttf Error: %s\n", TTF_GetError());
+    } else {
+        SDL_Color textColor = { 0, 0, 0, 0xff };
+        if (!loadGlyphs(textColor)) {
+            printf("Failed to render font glyphs!\n");
+            success = false;
+        }
+    }
+
+    particlesInit(&particles);
+
+    if (!arenaInit(&gFrameArena, FRAME_ARENA_SIZE)) {
+        printf("Failed to allocate frame arena!\n");
+        success = false;
     }
 
     // Load high score from file
@@ -351,30 +292,17 @@ bool loadMedia() {
     }
 
     // Init platform
-    platform.texture = loadTexture("assets/platform.png");
-    SDL_QueryTexture(platform.texture, NULL, NULL, &platform.w, &platform.h);
-    platform.x = (SCREEN_WIDTH / 2) - (platform.w / 2);
-    platform.y = 300;
+    platformTexture = loadTexture("assets/platform.png");
 
-    if (platform.texture == NULL) {
+    if (platformTexture == NULL) {
         printf("Failed to load platform!\n");
         success = false;
     }
 
     // Init survivor
-    survivor.texture = loadTexture("assets/survivor.png");
-    survivor.x = 200;
-    survivor.y = 100;
-    survivor.w = 64;
-    survivor.h = 64;
-    survivor.vX = 0;
-    survivor.vY = 0;
-    survivor.scaleX = 1;
-    survivor.scaleY = 1;
-    survivor.frameX = 0;
-    survivor.state = "state_idle";
-
-    if (survivor.texture == NULL) {
+    survivorTexture = loadTexture("assets/survivor.png");
+
+    if (survivorTexture == NULL) {
         printf("Failed to load survivor texture!\n");
         success = false;
     }
@@ -384,9 +312,6 @@ bool loadMedia() {
 
     // Init bullet
     bulletTexture = loadTexture("assets/bullet.png");
-    for (int i = 0; i < BULLET_COUNT; i++) {
-        SDL_QueryTexture(bulletTexture, NULL, NULL, &bullets[i].w, &bullets[i].h);
-    }
     
     return success;
 }
@@ -400,10 +325,13 @@ SDL_Texture* loadTexture(std::string path) {
     if (loadedSurface == NULL) {
         printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
     } else {
+        allocTrackSurface();
         
         newTexture = SDL_CreateTextureFromSurface(gRenderer, loadedSurface);
         if (newTexture == NULL) {
             printf("Unable to create texture from %s! SDL_Error: %s\n", path.c_str(), SDL_GetError());
+        } else {
+            allocTrackTexture();
         }
 
         SDL_FreeSurface(loadedSurface);
@@ -418,11 +346,11 @@ void close() {
     SDL_DestroyTexture(background.texture);
     background.texture = NULL;
 
-    SDL_DestroyTexture(platform.texture);
-    platform.texture = NULL;
+    SDL_DestroyTexture(platformTexture);
+    platformTexture = NULL;
 
-    SDL_DestroyTexture(survivor.texture);
-    survivor.texture = NULL;
+    SDL_DestroyTexture(survivorTexture);
+    survivorTexture = NULL;
 
     SDL_DestroyTexture(bulletTexture);
     bulletTexture = NULL;
@@ -430,6 +358,13 @@ void close() {
     SDL_DestroyTexture(zombieTexture);
     zombieTexture = NULL;
 
+    for (int i = 0; i <= GLYPH_LAST - GLYPH_FIRST; i++) {
+        SDL_DestroyTexture(glyphs[i].texture);
+        glyphs[i].texture = NULL;
+    }
+
+    arenaFree(&gFrameArena);
+
     //Destroy window
     SDL_DestroyRenderer(gRenderer);
     SDL_DestroyWindow(gWindow);
@@ -447,234 +382,139 @@ void close() {
 }
 
 
+// Input processing, SDL wants the keyboard read on the main thread
+uint8_t readInput() {
+    const Uint8* keys = SDL_GetKeyboardState(NULL);
+    uint8_t input = 0;
+    if (keys[SDL_SCANCODE_A]) input |= INPUT_LEFT;
+    if (keys[SDL_SCANCODE_D]) input |= INPUT_RIGHT;
+    if (keys[SDL_SCANCODE_W]) input |= INPUT_JUMP;
+    if (keys[SDL_SCANCODE_J]) input |= INPUT_SHOOT;
+    if (keys[SDL_SCANCODE_K]) input |= INPUT_STAB;
+    if (keys[SDL_SCANCODE_R]) input |= INPUT_RESTART;
+    return input;
+}
+
 // Game logic
-void update() {
+void update(uint8_t input) {
 
-    // Restart game
-    if (survivor.state == "state_dead") {
-        const Uint8* keys = SDL_GetKeyboardState(NULL);
-        if (keys[SDL_SCANCODE_R]) {
-            restart();
-        }
+    // Scripted play for the allocation test: walk, jump, shoot, stab and restart
+    if (allocTest) {
+        static const uint8_t script[] = { INPUT_RIGHT, INPUT_SHOOT, INPUT_LEFT, INPUT_STAB, INPUT_JUMP | INPUT_RIGHT, INPUT_SHOOT, INPUT_RESTART };
+        input = script[(tickCount / 30) % sizeof(script)];
     }
-    // Out of screen
-    if (survivor.y > SCREEN_HEIGHT && survivor.state != "state_dead") {
-        survivor.state = "state_dead";
-        survivor.alive = false;
-        saveHighScore();
-    }
-
-    if (survivor.state != "state_dead") {
-
-        
-        // Apply gravity
-        survivor.vY += world.gravity;
-        survivor.y += survivor.vY;
-
-        // Motion
-        survivor.x += survivor.vX;
 
-        // Platform collision
-        if (platformCollision(survivor.x, survivor.y, survivor.w, survivor.h)) {
+    bool wasDead = game.survivors[localSlot].state == STATE_DEAD;
 
-            survivor.y = platform.y - survivor.h; 
-            survivor.vY = 0;
-
-            if (survivor.state == "state_fall" || survivor.state == "state_jump") {
-                survivor.frameY = 0;
-                survivor.state = "state_idle";
-            }
-
-        } else if (survivor.state != "state_jump") {
-            survivor.state = "state_fall";
+    // Online the view carries the events to show this tick
+    if (online) {
+        clientUpdate(&client, input);
+        if (!clientView(&client, &game)) {
+            return;
         }
+        localSlot = client.slot;
+    } else {
+        uint8_t inputs[MAX_SURVIVORS] = { 0 };
+        inputs[localSlot] = input;
+        gameUpdate(&game, inputs);
+    }
 
-        // Input processing
-        const Uint8* keys = SDL_GetKeyboardState(NULL);
-        if (survivor.state != "state_shoot" && survivor.state != "state_stab" && survivor.state != "state_fall") {
-            
-            if (survivor.state == "state_jump") {
-                
-                if (keys[SDL_SCANCODE_D]) {
-                    survivor.vX = survivor.speed;
-                    survivor.scaleX = 1;
-                } else if (keys[SDL_SCANCODE_A]) {
-                    survivor.vX = -survivor.speed;
-                    survivor.scaleX = -1;
-                } else {
-                    survivor.vX = 0;
-                }
+    particlesEmitEvents(&particles, &game);
 
-            } else {
-                
-                if (keys[SDL_SCANCODE_W]) {
-                    survivor.vY = -survivor.jumpSpeed;
-                    survivor.frameY = 3;
-                    survivor.state = "state_jump";
-                } else if (keys[SDL_SCANCODE_J]) {
-                    survivor.frameX = 0;
-                    survivor.frameY = 2;
-                    survivor.vX = 0;
-                    survivor.animCompleted = false;
-                    survivor.shot = false;
-                    survivor.state = "state_shoot";
-                } else if (keys[SDL_SCANCODE_K]) {
-                    survivor.frameX = 0;
-                    survivor.frameY = 5;
-                    survivor.vX = 0;
-                    survivor.animCompleted = false;
-                    survivor.stab = false;
-                    survivor.state = "state_stab";
-                } else if (keys[SDL_SCANCODE_D]) {
-                    survivor.vX = survivor.speed;
-                    survivor.scaleX = 1;
-                    survivor.frameY = 1;
-                    survivor.state = "state_walk";
-                } else if (keys[SDL_SCANCODE_A]) {
-                    survivor.vX = -survivor.speed;
-                    survivor.scaleX = -1;
-                    survivor.frameY = 1;
-                    survivor.state = "state_walk";
-                } else {
-                    survivor.frameY = 0;
-                    survivor.vX = 0;
-                    survivor.state = "state_idle";
-                }
-           }
-        }
+    particlesUpdate(&particles, world.gravity, PARTICLE_DRAG);
 
-        // Player states
-        if (survivor.state == "state_shoot") {
+    // Keep the high score as soon as we die
+    if (!wasDead && game.survivors[localSlot].state == STATE_DEAD) {
+        updateHighScore();
+    }
+}
 
-            if (survivor.frameX / survivor.animSpeed == 2 && !survivor.shot) {
-                survivor.shot = true;
-                shootBullet();
-            }
+// Copies what render() needs out of the simulation
+void captureSnapshot(struct RenderSnapshot* snapshot) {
 
-            if (survivor.animCompleted) {
-                survivor.frameY = 0;
-                survivor.state = "state_idle";
-            }
+    // Bullets
+    snapshot->bulletCount = 0;
+    for (int i = 0; i < BULLET_COUNT; i++) {
+        struct Bullet* bullet = &game.bullets[i];
+        if (bullet->alive) {
+            struct Sprite* sprite = &snapshot->bullets[snapshot->bulletCount++];
+            sprite->dst = { .x = (int)bullet->x, .y = (int)bullet->y, .w = bullet->w, .h = bullet->h };
+            sprite->flip = SDL_FLIP_NONE;
         }
+    }
 
-        if (survivor.state == "state_stab") {
-
-            if (survivor.frameX / survivor.animSpeed == 2 && !survivor.stab) {
-                survivor.stab = true;
-                stabZombies();
-            }
-
-            if (survivor.animCompleted) {
-                survivor.frameY = 0;
-                survivor.state = "state_idle";
-            }
-        }
-    } else { // state dead
-        if (survivor.animCompleted) {
-            survivor.alive = false;
+    // Survivors
+    snapshot->survivorCount = 0;
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        struct Survivor* survivor = &game.survivors[i];
+        if (survivor->active && survivor->alive) {
+            struct Sprite* sprite = &snapshot->survivors[snapshot->survivorCount++];
+            sprite->src = { .x = (survivor->frameX / survivor->animSpeed) * survivor->w, .y = survivor->frameY * survivor->h, .w = survivor->w, .h = survivor->h };
+            sprite->dst = { .x = (int)survivor->x, .y = (int)survivor->y, .w = survivor->w, .h = survivor->h };
+            sprite->flip = survivor->scaleX == 1 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL;
         }
     }
 
     // Zombies
+    snapshot->zombieCount = 0;
     for (int i = 0; i < ZOMBIE_COUNT; i++) {
-        if (zombies[i].alive) {
-
-            // Out of screen
-            if (zombies[i].y > SCREEN_HEIGHT) {
-                zombies[i].alive = false;
-                score += 10;
-            }
-
-            // Apply gravity
-            zombies[i].vY += world.gravity;
-            zombies[i].y += zombies[i].vY;
-
-            // Motion
-            zombies[i].x += zombies[i].vX;
-
-            // Platform
-            if (zombies[i].state == "state_hit") {
-                continue;
-            }
-
-            if (platformCollision(zombies[i].x, zombies[i].y, zombies[i].w, zombies[i].h)) {
-                zombies[i].y = platform.y - zombies[i].h; 
-                zombies[i].vY = 0;
-
-                if (zombies[i].state == "state_fall") {
-                    zombies[i].state = "state_walk";
-                }
-            } else {
-                zombies[i].vX = 0;
-                zombies[i].state = "state_fall";
-            }
+        struct Zombie* zombie = &game.zombies[i];
+        if (zombie->alive) {
+            struct Sprite* sprite = &snapshot->zombies[snapshot->zombieCount++];
+            sprite->src = { .x = (zombie->frameX / zombieAnimSpeed) * zombie->w, .y = zombie->frameY * zombie->h, .w = zombie->w, .h = zombie->h };
+            sprite->dst = { .x = (int)zombie->x, .y = (int)zombie->y, .w = zombie->w, .h = zombie->h };
+            sprite->flip = zombie->dir == 1 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL;
+        }
+    }
 
-            if (zombies[i].state == "state_walk") {
+    particlesCapture(&particles, &snapshot->particles);
 
-                // Move
-                zombies[i].vX = zombieSpeed * zombies[i].dir;
+    // HUD
+    if (online && client.newestTick == 0) {
+        snprintf(snapshot->text, HUD_TEXT_SIZE, "Connecting...");
+    } else if (game.survivors[localSlot].state == STATE_DEAD) {
+        snprintf(snapshot->text, HUD_TEXT_SIZE, "Press R to restart");
+    } else {
+        snprintf(snapshot->text, HUD_TEXT_SIZE, "Score: %d - High Score: %d", game.score, (int)highScore);
+    }
+}
 
-                // Attack survivor if colliding
-                if (survivor.state != "state_dead" && collision(zombies[i].x, survivor.x, zombies[i].y, survivor.y, zombies[i].w, survivor.w, zombies[i].h, survivor.h)) {
-                    zombies[i].frameX = 0;
-                    zombies[i].frameY = 2;
-                    zombies[i].vX = 0;
-                    zombies[i].attack = false;
-                    zombies[i].animCompleted = false;
-                    zombies[i].state = "state_attack";
-                }
-            }
+// Simulation thread: fixed tick rate, publishes a snapshot every tick
+void simulate() {
 
-            if (zombies[i].state == "state_attack") {
-
-                // Attack survivor
-                if (zombies[i].frameX / zombieAnimSpeed == 3 && !zombies[i].attack && survivor.state != "state_jump") {
-                    zombies[i].attack = true;
-                    survivor.frameX = 0;
-                    survivor.frameY = 4;
-                    survivor.vX = survivor.vY = 0;
-                    survivor.animCompleted = false;
-                    survivor.state = "state_dead";
-                    saveHighScore();
-                }
-                
-                if (zombies[i].animCompleted) {
-                    zombies[i].frameX = 0;
-                    zombies[i].frameY = 0;
-                    zombies[i].state = "state_walk";
-                }
+    allocSetPhase(PHASE_UPDATE);
 
-            }
+    const std::chrono::microseconds tickLength(1000000 / TICK_RATE);
+    std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
 
-            
+    while (simRunning) {
 
+        // Fixed step: one update, and online one input, per elapsed tick,
+        // since the server consumes exactly one input per tick. A late
+        // wake-up catches up, but a long stall is dropped rather than replayed.
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - nextTick > tickLength * MAX_CATCHUP_TICKS) {
+            nextTick = now - tickLength * MAX_CATCHUP_TICKS;
         }
-    }
 
-    // Spawn zombie every N seconds
-    currentTime = SDL_GetTicks();
-    if (currentTime > lastSpawnTime + SPAWN_FREQ * 1000) {
-        spawnZombie();
-        lastSpawnTime = currentTime;
-    }
-
-    // Bullets
-    for (int i = 0; i < BULLET_COUNT; i++) {
-        if (bullets[i].alive) {
-            bullets[i].x += bulletSpeed * bullets[i].dir;
-            
-            // Out of screen
-            if (bullets[i].x + bullets[i].w < 0 || bullets[i].x > SCREEN_WIDTH) {
-                bullets[i].alive = false;
-            }
+        bool stepped = false;
+        while (nextTick <= now) {
+            update(gInput);
+            tickCount++;
+            nextTick += tickLength;
+            stepped = true;
+        }
 
-            // Hit zombie
-            hitZombies(&bullets[i]);
+        if (stepped) {
+            captureSnapshot(snapshotBack(&snapshots));
+            snapshotPublish(&snapshots);
         }
+
+        std::this_thread::sleep_until(nextTick);
     }
 }
 
-void render() {
+void render(const struct RenderSnapshot* snapshot) {
 
     // Clear screen
     SDL_RenderClear(gRenderer);
@@ -685,69 +525,120 @@ void render() {
 
     // Render platform
     SDL_Rect dstPlatf = { .x = platform.x, .y = platform.y, .w = platform.w, .h = platform.h };
-    SDL_RenderCopy(gRenderer, platform.texture, NULL, &dstPlatf);
+    SDL_RenderCopy(gRenderer, platformTexture, NULL, &dstPlatf);
 
     // Render bullets
-    for (int i = 0; i < BULLET_COUNT; i++) {
-        if (bullets[i].alive) {
-            SDL_Rect dstBullet = { .x = (int)bullets[i].x, .y = (int)bullets[i].y, .w = bullets[i].w, .h = bullets[i].h };
-            SDL_RenderCopy(gRenderer, bulletTexture, NULL, &dstBullet);
-        }
+    for (int i = 0; i < snapshot->bulletCount; i++) {
+        SDL_RenderCopy(gRenderer, bulletTexture, NULL, &snapshot->bullets[i].dst);
     }
 
-    // Render survivor
-    if (survivor.alive) {
-        SDL_Rect srcSurv = { .x = (survivor.frameX / survivor.animSpeed) * survivor.w, .y = survivor.frameY * survivor.h, .w = survivor.w, .h = survivor.h };
-        SDL_Rect dstSurv = { .x = (int)survivor.x, .y = (int)survivor.y, .w = survivor.w, .h = survivor.h };
-        SDL_RendererFlip flip = survivor.scaleX == 1 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL;
-        SDL_RenderCopyEx(gRenderer, survivor.texture, &srcSurv, &dstSurv, 0, NULL, flip); 
+    // Render survivors
+    for (int i = 0; i < snapshot->survivorCount; i++) {
+        const struct Sprite* sprite = &snapshot->survivors[i];
+        SDL_RenderCopyEx(gRenderer, survivorTexture, &sprite->src, &sprite->dst, 0, NULL, sprite->flip);
     }
 
     // Render zombies
-    for (int i = 0; i < ZOMBIE_COUNT; i++) {
-        if (zombies[i].alive) {
-            SDL_Rect srcZombie = { .x = (zombies[i].frameX / zombieAnimSpeed) * zombies[i].w, .y = zombies[i].frameY * zombies[i].h, .w = zombies[i].w, .h = zombies[i].h };
-            SDL_Rect dstZombie = { .x = (int)zombies[i].x, .y = (int)zombies[i].y, .w = zombies[i].w, .h = zombies[i].h };
-            SDL_RendererFlip flip = zombies[i].dir == 1 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL;
-            SDL_RenderCopyEx(gRenderer, zombieTexture, &srcZombie, &dstZombie, 0, NULL, flip);
+    for (int i = 0; i < snapshot->zombieCount; i++) {
+        const struct Sprite* sprite = &snapshot->zombies[i];
+        SDL_RenderCopyEx(gRenderer, zombieTexture, &sprite->src, &sprite->dst, 0, NULL, sprite->flip);
+    }
+
+    // Render particles in one batch
+    const struct ParticleFrame* frame = &snapshot->particles;
+    if (frame->count > 0) {
+        SDL_Vertex* vertices = (SDL_Vertex*)arenaAlloc(&gFrameArena, frame->count * 4 * sizeof(SDL_Vertex));
+        if (vertices != NULL) {
+            int count = particlesGeometry(frame, vertices, frame->count);
+            SDL_RenderGeometry(gRenderer, NULL, vertices, count * 4, particlesIndices(), count * 6);
         }
     }
 
     // Render text
-    SDL_Color textColor = { 0, 0, 0 };
-    std::string text;
-    if (survivor.state == "state_dead") {
-        text = "Press R to restart";
-    } else {
-        text = "Score: " + std::to_string(score) + " - High Score: " + std::to_string(highScore);
-    }
-    renderScoreText(text, textColor);
+    renderText(snapshot->text, 20, 20);
 
-    SDL_Rect dstScore = { .x = 20, .y = 20, .w = scoreWidth, .h = scoreHeight };
-    SDL_RenderCopy(gRenderer, scoreTexture, NULL, &dstScore);
-    
     // Update the screen
+    allocSetPhase(PHASE_PRESENT);
     SDL_RenderPresent(gRenderer);
+}
+
+// Allocation bookkeeping at the end of every frame, returns false when the test fails
+bool endFrame() {
+
+    static struct AllocFrame total;
+    static int totalFrames = 0;
 
-    // Update frames
-    survivor.frameX++;
-    if (survivor.frameX / survivor.animSpeed >= 4) {
-        survivor.animCompleted = true;
-        survivor.frameX = 0;
+    allocSetPhase(PHASE_OTHER);
+    arenaReset(&gFrameArena);
+    frameCount++;
+
+    struct AllocFrame frame;
+    allocEndFrame(&frame);
+
+    // Loading and the first frames are allowed to allocate
+    if (frameCount <= ALLOC_WARMUP) {
+        return true;
     }
 
-    for (int i = 0; i < ZOMBIE_COUNT; i++) {
-        zombies[i].frameX++;
-        if (zombies[i].alive && zombies[i].frameX / zombieAnimSpeed >= 4) {
-            zombies[i].animCompleted = true;
-            zombies[i].frameX = 0;
+    if (allocTest && allocTotal(&frame) > 0) {
+        printf("Allocation test failed at frame %d!\n", frameCount);
+        allocPrint(&frame, 1);
+        return false;
+    }
+
+    if (allocReport) {
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            total.allocations[i] += frame.allocations[i];
+            total.bytes[i] += frame.bytes[i];
+        }
+        total.surfaces += frame.surfaces;
+        total.textures += frame.textures;
+
+        if (++totalFrames == 60) {
+            allocPrint(&total, totalFrames);
+            printf("Frame arena peak: %zu bytes\n", gFrameArena.peak);
+            total = AllocFrame();
+            totalFrames = 0;
         }
     }
 
+    return true;
 }
 
 int main(int argc, char* args[]) {
 
+    // Play online with: ./main host [--port N] [--lag ms] [--jitter ms] [--loss percent]
+    const char* host = NULL;
+    int port = NET_PORT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(args[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(args[++i]);
+        } else if (strcmp(args[i], "--lag") == 0 && i + 1 < argc) {
+            client.sock.shim.latency = atoi(args[++i]);
+        } else if (strcmp(args[i], "--jitter") == 0 && i + 1 < argc) {
+            client.sock.shim.jitter = atoi(args[++i]);
+        } else if (strcmp(args[i], "--loss") == 0 && i + 1 < argc) {
+            client.sock.shim.loss = atoi(args[++i]);
+        } else if (strcmp(args[i], "--alloc-report") == 0) {
+            allocReport = true;
+        } else if (strcmp(args[i], "--alloc-test") == 0) {
+            allocTest = true;
+        } else {
+            host = args[i];
+        }
+    }
+
+    if (host != NULL) {
+        if (!clientConnect(&client, host, port)) {
+            printf("Failed to connect!\n");
+            return 1;
+        }
+        online = true;
+    }
+
+    bool failed = false;
+
 	//Start up SDL and create window
 	if(!init()) {
 		printf("Failed to initialize!\n");
@@ -765,10 +656,15 @@ int main(int argc, char* args[]) {
             // Event handler
             SDL_Event e;
 
+            // Start the simulation
+            simRunning = true;
+            std::thread simThread(simulate);
+
             // While application is running
             while(!quit) {
 
                 // Handle events on queue
+                allocSetPhase(PHASE_EVENTS);
                 while(SDL_PollEvent(&e) != 0) {
 
                     // User requests quit
@@ -777,19 +673,43 @@ int main(int argc, char* args[]) {
                     }
                 }
 
-                // Update game
-                update();
+                gInput = readInput();
+
+                // Render the newest simulation frame, nothing to redraw until
+                // the next one, which also keeps us from spinning without vsync
+                bool fresh;
+                const struct RenderSnapshot* snapshot = snapshotAcquire(&snapshots, &fresh);
+                if (fresh) {
+                    allocSetPhase(PHASE_RENDER);
+                    render(snapshot);
 
-                
-                // Render game
-                render();
+                    if (!endFrame()) {
+                        failed = true;
+                        quit = true;
+                    }
+                } else {
+                    SDL_Delay(1);
+                }
 
+                if (allocTest && tickCount >= (unsigned int)ALLOC_TEST_TICKS) {
+                    printf("Allocation test passed: no allocations in %d frames and %d ticks\n", frameCount - ALLOC_WARMUP, ALLOC_TEST_TICKS);
+                    quit = true;
+                }
             }
+
+            simRunning = false;
+            simThread.join();
+
+            saveHighScore();
         }
 	}
 
+    if (online) {
+        clientDisconnect(&client);
+    }
+
 	//Free resources and close SDL
 	close();
 
-	return 0;
+	return failed ? 1 : 0;
 }
@@ -0,0 +1,589 @@
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+
+// All zero baseline for full snapshots
+static const struct NetState zeroState = NetState();
+
+uint32_t netTime() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool netOpen(struct NetSocket* sock, int port) {
+
+    sock->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock->fd < 0) {
+        printf("Unable to create socket!\n");
+        return false;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(sock->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        printf("Unable to bind port %d!\n", port);
+        netClose(sock);
+        return false;
+    }
+
+    fcntl(sock->fd, F_SETFL, fcntl(sock->fd, F_GETFL, 0) | O_NONBLOCK);
+    sock->queueCount = 0;
+
+    return true;
+}
+
+void netClose(struct NetSocket* sock) {
+    if (sock->fd >= 0) {
+        close(sock->fd);
+        sock->fd = -1;
+    }
+}
+
+bool netResolve(const char* host, int port, struct NetAddress* address) {
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo* result = NULL;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0 || result == NULL) {
+        printf("Unable to resolve %s!\n", host);
+        return false;
+    }
+
+    address->host = ntohl(((struct sockaddr_in*)result->ai_addr)->sin_addr.s_addr);
+    address->port = port;
+    freeaddrinfo(result);
+
+    return true;
+}
+
+bool netSameAddress(const struct NetAddress* a, const struct NetAddress* b) {
+    return a->host == b->host && a->port == b->port;
+}
+
+static void sendNow(struct NetSocket* sock, const struct NetAddress* to, const uint8_t* data, int size) {
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(to->host);
+    addr.sin_port = htons(to->port);
+
+    sendto(sock->fd, data, size, 0, (struct sockaddr*)&addr, sizeof(addr));
+    sock->bytesSent += size;
+}
+
+void netSend(struct NetSocket* sock, const struct NetAddress* to, const uint8_t* data, int size) {
+
+    struct NetShim* shim = &sock->shim;
+
+    // Dropped on the floor
+    if (shim->loss > 0 && (int)(xorshift32(&sock->seed) % 100) < shim->loss) {
+        return;
+    }
+
+    if (shim->latency == 0 && shim->jitter == 0) {
+        sendNow(sock, to, data, size);
+        return;
+    }
+
+    if (sock->queueCount == NET_SHIM_QUEUE || size > NET_MAX_PACKET) {
+        return;
+    }
+
+    struct NetPacket* packet = &sock->queue[sock->queueCount++];
+    packet->to = *to;
+    packet->sendTime = netTime() + shim->latency + (shim->jitter > 0 ? xorshift32(&sock->seed) % (shim->jitter + 1) : 0);
+    packet->size = size;
+    memcpy(packet->data, data, size);
+}
+
+void netFlush(struct NetSocket* sock) {
+
+    uint32_t now = netTime();
+
+    int kept = 0;
+    for (int i = 0; i < sock->queueCount; i++) {
+        struct NetPacket* packet = &sock->queue[i];
+        if ((int32_t)(now - packet->sendTime) >= 0) {
+            sendNow(sock, &packet->to, packet->data, packet->size);
+        } else {
+            if (kept != i) {
+                sock->queue[kept] = *packet;
+            }
+            kept++;
+        }
+    }
+
+    sock->queueCount = kept;
+}
+
+int netReceive(struct NetSocket* sock, struct NetAddress* from, uint8_t* data, int size) {
+
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    int received = recvfrom(sock->fd, data, size, 0, (struct sockaddr*)&addr, &addrLen);
+    if (received <= 0) {
+        return 0;
+    }
+
+    from->host = ntohl(addr.sin_addr.s_addr);
+    from->port = ntohs(addr.sin_port);
+
+    return received;
+}
+
+// Entity flags
+enum {
+    FLAG_ALIVE = 1 << 0,
+    FLAG_ACTIVE = 1 << 1,
+    FLAG_ANIM_COMPLETED = 1 << 2,
+    FLAG_ACTION = 1 << 3,
+    FLAG_ACTION2 = 1 << 4,
+    FLAG_FLIP = 1 << 5
+};
+
+static int32_t quantize(float value) {
+    return (int32_t)(value * NET_POS_SCALE + (value < 0 ? -0.5f : 0.5f));
+}
+
+static float dequantize(int32_t value) {
+    return (float)value / NET_POS_SCALE;
+}
+
+void netCapture(const struct Game* game, struct NetState* state) {
+
+    *state = zeroState;
+    state->tick = game->tick;
+
+    struct NetEntity* header = &state->entities[0];
+    header->f[0] = game->score;
+    header->f[1] = game->lastSpawnTick;
+    header->f[2] = (int32_t)game->seed;
+
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        const struct Survivor* survivor = &game->survivors[i];
+        struct NetEntity* e = &state->entities[NET_SURVIVOR_BASE + i];
+        if (!survivor->active) {
+            continue;
+        }
+
+        e->f[0] = quantize(survivor->x);
+        e->f[1] = quantize(survivor->y);
+        e->f[2] = quantize(survivor->vX);
+        e->f[3] = quantize(survivor->vY);
+        e->f[4] = survivor->frameX;
+        e->f[5] = survivor->frameY;
+        e->f[6] = survivor->state;
+        e->f[7] = FLAG_ACTIVE |
+            (survivor->alive ? FLAG_ALIVE : 0) |
+            (survivor->animCompleted ? FLAG_ANIM_COMPLETED : 0) |
+            (survivor->shot ? FLAG_ACTION : 0) |
+            (survivor->stab ? FLAG_ACTION2 : 0) |
+            (survivor->scaleX == -1 ? FLAG_FLIP : 0);
+    }
+
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        const struct Zombie* zombie = &game->zombies[i];
+        struct NetEntity* e = &state->entities[NET_ZOMBIE_BASE + i];
+        if (!zombie->alive) {
+            continue;
+        }
+
+        e->f[0] = quantize(zombie->x);
+        e->f[1] = quantize(zombie->y);
+        e->f[2] = quantize(zombie->vX);
+        e->f[3] = quantize(zombie->vY);
+        e->f[4] = zombie->frameX;
+        e->f[5] = zombie->frameY;
+        e->f[6] = zombie->state | (zombie->target << 8);
+        e->f[7] = FLAG_ALIVE |
+            (zombie->animCompleted ? FLAG_ANIM_COMPLETED : 0) |
+            (zombie->attack ? FLAG_ACTION : 0) |
+            (zombie->dir == -1 ? FLAG_FLIP : 0);
+    }
+
+    for (int i = 0; i < BULLET_COUNT; i++) {
+        const struct Bullet* bullet = &game->bullets[i];
+        struct NetEntity* e = &state->entities[NET_BULLET_BASE + i];
+        if (!bullet->alive) {
+            continue;
+        }
+
+        e->f[0] = quantize(bullet->x);
+        e->f[1] = quantize(bullet->y);
+        e->f[6] = bullet->owner;
+        e->f[7] = FLAG_ALIVE | (bullet->dir == -1 ? FLAG_FLIP : 0);
+    }
+}
+
+bool netValidState(const struct NetState* state) {
+
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        const struct NetEntity* e = &state->entities[NET_SURVIVOR_BASE + i];
+        if ((uint32_t)e->f[6] > STATE_DEAD) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        const struct NetEntity* e = &state->entities[NET_ZOMBIE_BASE + i];
+        if ((e->f[6] & 0xff) > STATE_DEAD || (uint32_t)e->f[6] >> 8 >= (uint32_t)MAX_SURVIVORS) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < BULLET_COUNT; i++) {
+        const struct NetEntity* e = &state->entities[NET_BULLET_BASE + i];
+        if ((uint32_t)e->f[6] >= (uint32_t)MAX_SURVIVORS) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void netRestore(const struct NetState* state, struct Game* game) {
+
+    gameInit(game, (uint32_t)state->entities[0].f[2]);
+    game->tick = state->tick;
+    game->score = state->entities[0].f[0];
+    game->lastSpawnTick = state->entities[0].f[1];
+
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        struct Survivor* survivor = &game->survivors[i];
+        const struct NetEntity* e = &state->entities[NET_SURVIVOR_BASE + i];
+
+        survivor->x = dequantize(e->f[0]);
+        survivor->y = dequantize(e->f[1]);
+        survivor->w = SPRITE_SIZE;
+        survivor->h = SPRITE_SIZE;
+        survivor->vX = dequantize(e->f[2]);
+        survivor->vY = dequantize(e->f[3]);
+        survivor->frameX = e->f[4];
+        survivor->frameY = e->f[5];
+        survivor->state = (State)e->f[6];
+        survivor->active = e->f[7] & FLAG_ACTIVE;
+        survivor->alive = e->f[7] & FLAG_ALIVE;
+        survivor->animCompleted = e->f[7] & FLAG_ANIM_COMPLETED;
+        survivor->shot = e->f[7] & FLAG_ACTION;
+        survivor->stab = e->f[7] & FLAG_ACTION2;
+        survivor->scaleX = e->f[7] & FLAG_FLIP ? -1 : 1;
+        survivor->scaleY = 1;
+    }
+
+    for (int i = 0; i < ZOMBIE_COUNT; i++) {
+        struct Zombie* zombie = &game->zombies[i];
+        const struct NetEntity* e = &state->entities[NET_ZOMBIE_BASE + i];
+
+        zombie->x = dequantize(e->f[0]);
+        zombie->y = dequantize(e->f[1]);
+        zombie->vX = dequantize(e->f[2]);
+        zombie->vY = dequantize(e->f[3]);
+        zombie->frameX = e->f[4];
+        zombie->frameY = e->f[5];
+        zombie->state = (State)(e->f[6] & 0xff);
+        zombie->target = (uint32_t)e->f[6] >> 8;
+        zombie->alive = e->f[7] & FLAG_ALIVE;
+        zombie->animCompleted = e->f[7] & FLAG_ANIM_COMPLETED;
+        zombie->attack = e->f[7] & FLAG_ACTION;
+        zombie->dir = e->f[7] & FLAG_FLIP ? -1 : 1;
+    }
+
+    for (int i = 0; i < BULLET_COUNT; i++) {
+        struct Bullet* bullet = &game->bullets[i];
+        const struct NetEntity* e = &state->entities[NET_BULLET_BASE + i];
+
+        bullet->x = dequantize(e->f[0]);
+        bullet->y = dequantize(e->f[1]);
+        bullet->owner = e->f[6];
+        bullet->alive = e->f[7] & FLAG_ALIVE;
+        bullet->dir = e->f[7] & FLAG_FLIP ? -1 : 1;
+    }
+}
+
+void netLerp(const struct NetState* a, const struct NetState* b, float t, struct NetState* out) {
+
+    *out = *a;
+
+    for (int i = NET_SURVIVOR_BASE; i < NET_ENTITY_COUNT; i++) {
+        const struct NetEntity* ea = &a->entities[i];
+        const struct NetEntity* eb = &b->entities[i];
+
+        // Skip slots that were reused or teleported in between
+        if (!(ea->f[7] & FLAG_ALIVE) || !(eb->f[7] & FLAG_ALIVE)) {
+            continue;
+        }
+
+        int32_t dx = eb->f[0] - ea->f[0];
+        int32_t dy = eb->f[1] - ea->f[1];
+        if (dx * dx + dy * dy > (SPRITE_SIZE * NET_POS_SCALE) * (SPRITE_SIZE * NET_POS_SCALE)) {
+            continue;
+        }
+
+        out->entities[i].f[0] = ea->f[0] + (int32_t)(dx * t);
+        out->entities[i].f[1] = ea->f[1] + (int32_t)(dy * t);
+    }
+}
+
+// Varint writer/reader over a fixed buffer
+struct NetBuffer {
+    uint8_t* data;
+    int size;
+    int pos;
+    bool overflow;
+};
+
+static void putByte(struct NetBuffer* buf, uint8_t value) {
+    if (buf->pos >= buf->size) {
+        buf->overflow = true;
+        return;
+    }
+    buf->data[buf->pos++] = value;
+}
+
+static void putVarint(struct NetBuffer* buf, int32_t value) {
+
+    // Zigzag so small negative deltas stay short
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    while (v >= 0x80) {
+        putByte(buf, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    putByte(buf, (uint8_t)v);
+}
+
+static bool getVarint(const uint8_t* data, int size, int* pos, int32_t* value) {
+
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= size) {
+            return false;
+        }
+        uint8_t byte = data[(*pos)++];
+        v |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int varintSize(int32_t value) {
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    int size = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// Bytes needed to send one entity's changes, 0 if it did not change
+static int entityDeltaSize(const struct NetEntity* from, const struct NetEntity* to) {
+
+    int size = 0;
+    for (int f = 0; f < NET_FIELDS; f++) {
+        if (from->f[f] != to->f[f]) {
+            size += varintSize((int32_t)((uint32_t)to->f[f] - (uint32_t)from->f[f]));
+        }
+    }
+
+    return size > 0 ? size + 1 : 0;
+}
+
+// Layout: one bit per entity that changed, then for each of those a field
+// mask followed by the varint difference of every changed field.
+int netWriteDelta(const struct NetState* base, const struct NetState* state, int* cursor, uint8_t* data, int size, struct NetState* sent) {
+
+    if (base == NULL) {
+        base = &zeroState;
+    }
+
+    const int maskBytes = (NET_ENTITY_COUNT + 7) / 8;
+    if (size < maskBytes) {
+        return -1;
+    }
+
+    // Pick what fits, the header and survivors first
+    bool selected[NET_ENTITY_COUNT];
+    int used = maskBytes;
+
+    for (int i = 0; i < NET_ZOMBIE_BASE; i++) {
+        int entitySize = entityDeltaSize(&base->entities[i], &state->entities[i]);
+        selected[i] = entitySize > 0;
+        used += entitySize;
+    }
+
+    if (used > size) {
+        return -1;
+    }
+
+    const int others = NET_ENTITY_COUNT - NET_ZOMBIE_BASE;
+    int start = *cursor % others;
+    bool skipped = false;
+
+    for (int k = 0; k < others; k++) {
+        int i = NET_ZOMBIE_BASE + (start + k) % others;
+        int entitySize = entityDeltaSize(&base->entities[i], &state->entities[i]);
+        selected[i] = entitySize > 0 && used + entitySize <= size;
+
+        if (selected[i]) {
+            used += entitySize;
+        } else if (entitySize > 0 && !skipped) {
+            *cursor = (start + k) % others;
+            skipped = true;
+        }
+    }
+
+    // Write them in entity order
+    memset(data, 0, maskBytes);
+    struct NetBuffer buf = { data, size, maskBytes, false };
+
+    *sent = *base;
+    sent->tick = state->tick;
+
+    for (int i = 0; i < NET_ENTITY_COUNT; i++) {
+        if (!selected[i]) {
+            continue;
+        }
+
+        const struct NetEntity* from = &base->entities[i];
+        const struct NetEntity* to = &state->entities[i];
+
+        uint8_t fieldMask = 0;
+        for (int f = 0; f < NET_FIELDS; f++) {
+            if (from->f[f] != to->f[f]) {
+                fieldMask |= 1 << f;
+            }
+        }
+
+        data[i / 8] |= 1 << (i % 8);
+        putByte(&buf, fieldMask);
+        for (int f = 0; f < NET_FIELDS; f++) {
+            if (fieldMask & (1 << f)) {
+                putVarint(&buf, (int32_t)((uint32_t)to->f[f] - (uint32_t)from->f[f]));
+            }
+        }
+
+        sent->entities[i] = *to;
+    }
+
+    return buf.overflow ? -1 : buf.pos;
+}
+
+bool netReadDelta(const struct NetState* base, struct NetState* state, const uint8_t* data, int size) {
+
+    if (base == NULL) {
+        base = &zeroState;
+    }
+
+    const int maskBytes = (NET_ENTITY_COUNT + 7) / 8;
+    if (size < maskBytes) {
+        return false;
+    }
+
+    int pos = maskBytes;
+    for (int i = 0; i < NET_ENTITY_COUNT; i++) {
+        state->entities[i] = base->entities[i];
+
+        if (!(data[i / 8] & (1 << (i % 8)))) {
+            continue;
+        }
+
+        if (pos >= size) {
+            return false;
+        }
+
+        uint8_t fieldMask = data[pos++];
+        for (int f = 0; f < NET_FIELDS; f++) {
+            if (fieldMask & (1 << f)) {
+                int32_t delta;
+                if (!getVarint(data, size, &pos, &delta)) {
+                    return false;
+                }
+                state->entities[i].f[f] = (int32_t)((uint32_t)base->entities[i].f[f] + (uint32_t)delta);
+            }
+        }
+    }
+
+    return true;
+}
+
+// Count, then type, source + 1, x, y and dir per event, positions in whole pixels
+static const int EVENT_BYTES = 7;
+
+int netWriteEvents(const struct Event* events, int count, uint8_t* data, int size) {
+
+    if (1 + count * EVENT_BYTES > size) {
+        return -1;
+    }
+
+    data[0] = count;
+    uint8_t* p = data + 1;
+    for (int i = 0; i < count; i++, p += EVENT_BYTES) {
+        const struct Event* event = &events[i];
+        int16_t x = (int16_t)event->x;
+        int16_t y = (int16_t)event->y;
+        p[0] = event->type;
+        p[1] = event->source + 1;
+        p[2] = x;
+        p[3] = x >> 8;
+        p[4] = y;
+        p[5] = y >> 8;
+        p[6] = (int8_t)event->dir;
+    }
+
+    return 1 + count * EVENT_BYTES;
+}
+
+int netReadEvents(const uint8_t* data, int size, struct Event* events, int* count) {
+
+    if (size < 1 || data[0] > EVENT_COUNT || 1 + data[0] * EVENT_BYTES > size) {
+        return -1;
+    }
+
+    *count = data[0];
+    const uint8_t* p = data + 1;
+    for (int i = 0; i < *count; i++, p += EVENT_BYTES) {
+        struct Event* event = &events[i];
+        if (p[0] > EVENT_DEATH || p[1] > MAX_SURVIVORS) {
+            return -1;
+        }
+        event->type = (EventType)p[0];
+        event->source = p[1] - 1;
+        event->x = (int16_t)(p[2] | (p[3] << 8));
+        event->y = (int16_t)(p[4] | (p[5] << 8));
+        event->dir = (int8_t)p[6];
+    }
+
+    return 1 + *count * EVENT_BYTES;
+}
+
+void netPut32(uint8_t* data, uint32_t value) {
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+uint32_t netGet32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
@@ -0,0 +1,135 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdint.h>
+#include "game.h"
+
+const int NET_PORT = 27960;
+const int NET_MAX_PACKET = 4096;
+
+// Snapshots kept on both ends as delta baselines
+const int NET_HISTORY = 64;
+
+// Past inputs resent with every command so a lost packet costs nothing
+const int NET_INPUT_REDUNDANCY = 16;
+
+// Packets held back by the latency shim
+const int NET_SHIM_QUEUE = 256;
+
+// Snapshot sent without a baseline
+const uint32_t NET_NO_BASE = 0xffffffff;
+
+// Snapshot bytes each client may receive per second, and per packet to stay
+// under a typical MTU. Crowded games send smaller deltas less often instead
+// of more bandwidth.
+const int NET_CLIENT_RATE = 20000;
+const int NET_SNAPSHOT_BUDGET = 1200;
+
+// Positions and velocities travel as fixed point with this many steps per pixel
+const int NET_POS_SCALE = 8;
+
+const int NET_FIELDS = 8;
+
+// World header, then survivors, zombies and bullets
+const int NET_ENTITY_COUNT = 1 + MAX_SURVIVORS + ZOMBIE_COUNT + BULLET_COUNT;
+const int NET_SURVIVOR_BASE = 1;
+const int NET_ZOMBIE_BASE = NET_SURVIVOR_BASE + MAX_SURVIVORS;
+const int NET_BULLET_BASE = NET_ZOMBIE_BASE + ZOMBIE_COUNT;
+
+// Message types, first byte of every packet
+enum {
+    MSG_CONNECT,
+    MSG_ACCEPT,
+    MSG_REJECT,
+    MSG_INPUT,
+    MSG_SNAPSHOT,
+    MSG_DISCONNECT
+};
+
+// IPv4 address and port in host byte order
+struct NetAddress {
+    uint32_t host;
+    uint16_t port;
+};
+
+// Simulated network conditions, applied to outgoing packets
+struct NetShim {
+    int latency = 0; // ms
+    int jitter = 0;  // ms, added on top of latency
+    int loss = 0;    // percent of packets dropped
+};
+
+struct NetPacket {
+    struct NetAddress to;
+    uint32_t sendTime;
+    int size;
+    uint8_t data[NET_MAX_PACKET];
+};
+
+struct NetSocket {
+    int fd = -1;
+    struct NetShim shim;
+    struct NetPacket queue[NET_SHIM_QUEUE];
+    int queueCount = 0;
+    uint32_t seed = 0x2545f491;
+    unsigned int bytesSent = 0;
+};
+
+// Quantized entity, every field is delta coded on its own
+struct NetEntity {
+    int32_t f[NET_FIELDS];
+};
+
+// Everything a client needs to rebuild the game at one tick
+struct NetState {
+    uint32_t tick;
+    struct NetEntity entities[NET_ENTITY_COUNT];
+};
+
+// Milliseconds since an arbitrary start
+uint32_t netTime();
+
+// Opens a non-blocking UDP socket, port 0 picks any free port
+bool netOpen(struct NetSocket* sock, int port);
+void netClose(struct NetSocket* sock);
+bool netResolve(const char* host, int port, struct NetAddress* address);
+bool netSameAddress(const struct NetAddress* a, const struct NetAddress* b);
+
+// Queues a packet through the shim, netFlush sends the ones that are due
+void netSend(struct NetSocket* sock, const struct NetAddress* to, const uint8_t* data, int size);
+void netFlush(struct NetSocket* sock);
+
+// Returns the size of the next pending packet, 0 if there is none
+int netReceive(struct NetSocket* sock, struct NetAddress* from, uint8_t* data, int size);
+
+// Conversion between the simulation and its network form. Only restore
+// states that passed netValidState, received data is untrusted.
+void netCapture(const struct Game* game, struct NetState* state);
+void netRestore(const struct NetState* state, struct Game* game);
+
+// False if any state, target or owner is out of range
+bool netValidState(const struct NetState* state);
+
+// Blends positions of entities present in both states, everything else comes from a
+void netLerp(const struct NetState* a, const struct NetState* b, float t, struct NetState* out);
+
+// Delta coding against a baseline, NULL means the all-zero state.
+// netWriteDelta fits what it can in size bytes: the header and survivors
+// always, then zombies and bullets in turn from *cursor, which moves to the
+// first one left out so it goes first next time. sent gets what the
+// receiver will rebuild, the baseline for later deltas. Returns the bytes
+// written or -1 if not even the header and survivors fit.
+int netWriteDelta(const struct NetState* base, const struct NetState* state, int* cursor, uint8_t* data, int size, struct NetState* sent);
+bool netReadDelta(const struct NetState* base, struct NetState* state, const uint8_t* data, int size);
+
+// Gameplay events of one tick, sent along with its snapshot for effects.
+// netWriteEvents returns the bytes written or -1 if the buffer is too small,
+// netReadEvents the bytes read or -1 if the data is malformed.
+int netWriteEvents(const struct Event* events, int count, uint8_t* data, int size);
+int netReadEvents(const uint8_t* data, int size, struct Event* events, int* count);
+
+// Little endian packet helpers
+void netPut32(uint8_t* data, uint32_t value);
+uint32_t netGet32(const uint8_t* data);
+
+#endif
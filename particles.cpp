@@ -0,0 +1,195 @@
+#include "particles.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static int indices[PARTICLE_COUNT * 6];
+
+static float randFloat(struct Particles* particles) {
+    return (xorshift32(&particles->seed) >> 8) * (1.0f / 16777216.0f);
+}
+
+void particlesInit(struct Particles* particles) {
+    particles->count = 0;
+    particles->seed = 0x1b873593;
+
+    // Two triangles per quad
+    for (int i = 0; i < PARTICLE_COUNT; i++) {
+        int* quad = &indices[i * 6];
+        quad[0] = i * 4;
+        quad[1] = i * 4 + 1;
+        quad[2] = i * 4 + 2;
+        quad[3] = i * 4;
+        quad[4] = i * 4 + 2;
+        quad[5] = i * 4 + 3;
+    }
+}
+
+void particlesEmit(struct Particles* particles, float x, float y, int count, float dirX, float dirY, float speed, SDL_Color color) {
+
+    for (int k = 0; k < count && particles->count < PARTICLE_COUNT; k++) {
+        int i = particles->count++;
+
+        float spreadX = randFloat(particles) * 2 - 1;
+        float spreadY = randFloat(particles) * 2 - 1;
+        float scale = speed * (0.3f + 0.7f * randFloat(particles));
+
+        particles->x[i] = x;
+        particles->y[i] = y;
+        particles->vX[i] = (dirX + spreadX * 0.6f) * scale;
+        particles->vY[i] = (dirY + spreadY * 0.6f) * scale;
+        particles->life[i] = 1;
+        particles->fade[i] = 1.0f / (20 + 40 * randFloat(particles));
+
+        // Slight shade variation
+        float shade = 0.7f + 0.3f * randFloat(particles);
+        particles->color[i].r = color.r * shade;
+        particles->color[i].g = color.g * shade;
+        particles->color[i].b = color.b * shade;
+        particles->color[i].a = 0xff;
+    }
+}
+
+void particlesEmitEvents(struct Particles* particles, const struct Game* game) {
+
+    const SDL_Color blood = { 0x8a, 0x1c, 0x1c, 0xff };
+    const SDL_Color flesh = { 0x5a, 0x7a, 0x3a, 0xff };
+
+    for (int i = 0; i < game->eventCount; i++) {
+        const struct Event* event = &game->events[i];
+        switch (event->type) {
+            case EVENT_HIT:
+                particlesEmit(particles, event->x, event->y, 40, event->dir, -0.3f, 4, blood);
+                break;
+            case EVENT_STAB:
+                particlesEmit(particles, event->x, event->y, 80, event->dir, -1, 6, blood);
+                break;
+            case EVENT_DEATH:
+                particlesEmit(particles, event->x, event->y, 200, 0, -1, 9, flesh);
+                break;
+        }
+    }
+}
+
+// Swaps dead particles out with the last live one
+static void compact(struct Particles* particles) {
+
+    int i = 0;
+    while (i < particles->count) {
+        if (particles->life[i] > 0) {
+            i++;
+            continue;
+        }
+
+        int last = --particles->count;
+        particles->x[i] = particles->x[last];
+        particles->y[i] = particles->y[last];
+        particles->vX[i] = particles->vX[last];
+        particles->vY[i] = particles->vY[last];
+        particles->life[i] = particles->life[last];
+        particles->fade[i] = particles->fade[last];
+        particles->color[i] = particles->color[last];
+    }
+}
+
+void particlesUpdateScalar(struct Particles* particles, float gravity, float drag) {
+
+    for (int i = 0; i < particles->count; i++) {
+        particles->vX[i] *= drag;
+        particles->vY[i] = (particles->vY[i] + gravity) * drag;
+        particles->x[i] += particles->vX[i];
+        particles->y[i] += particles->vY[i];
+        particles->life[i] -= particles->fade[i];
+
+        // Off the bottom of the screen
+        if (particles->y[i] > SCREEN_HEIGHT) {
+            particles->life[i] = 0;
+        }
+    }
+
+    compact(particles);
+}
+
+void particlesUpdate(struct Particles* particles, float gravity, float drag) {
+
+#ifdef __SSE2__
+    const __m128 g = _mm_set1_ps(gravity);
+    const __m128 d = _mm_set1_ps(drag);
+    const __m128 bottom = _mm_set1_ps(SCREEN_HEIGHT);
+
+    // Capacity is a multiple of 4, so the padding lanes are always in bounds
+    int count = (particles->count + 3) & ~3;
+
+    for (int i = 0; i < count; i += 4) {
+        __m128 vX = _mm_mul_ps(_mm_load_ps(particles->vX + i), d);
+        __m128 vY = _mm_mul_ps(_mm_add_ps(_mm_load_ps(particles->vY + i), g), d);
+        __m128 x = _mm_add_ps(_mm_load_ps(particles->x + i), vX);
+        __m128 y = _mm_add_ps(_mm_load_ps(particles->y + i), vY);
+        __m128 life = _mm_sub_ps(_mm_load_ps(particles->life + i), _mm_load_ps(particles->fade + i));
+
+        // Off the bottom of the screen
+        life = _mm_and_ps(life, _mm_cmple_ps(y, bottom));
+
+        _mm_store_ps(particles->vX + i, vX);
+        _mm_store_ps(particles->vY + i, vY);
+        _mm_store_ps(particles->x + i, x);
+        _mm_store_ps(particles->y + i, y);
+        _mm_store_ps(particles->life + i, life);
+    }
+
+    compact(particles);
+#else
+    particlesUpdateScalar(particles, gravity, drag);
+#endif
+}
+
+void particlesCapture(const struct Particles* particles, struct ParticleFrame* frame) {
+
+    frame->count = particles->count;
+    memcpy(frame->x, particles->x, particles->count * sizeof(float));
+    memcpy(frame->y, particles->y, particles->count * sizeof(float));
+
+    for (int i = 0; i < particles->count; i++) {
+        frame->color[i] = particles->color[i];
+        frame->color[i].a = (Uint8)(particles->life[i] * 255);
+    }
+}
+
+int particlesGeometry(const struct ParticleFrame* frame, SDL_Vertex* vertices, int maxParticles) {
+
+    int count = frame->count < maxParticles ? frame->count : maxParticles;
+
+    for (int i = 0; i < count; i++) {
+        float x0 = frame->x[i];
+        float y0 = frame->y[i];
+        float x1 = x0 + PARTICLE_SIZE;
+        float y1 = y0 + PARTICLE_SIZE;
+
+        SDL_Color color = frame->color[i];
+
+        SDL_Vertex* quad = &vertices[i * 4];
+        quad[0].position.x = x0;
+        quad[0].position.y = y0;
+        quad[1].position.x = x1;
+        quad[1].position.y = y0;
+        quad[2].position.x = x1;
+        quad[2].position.y = y1;
+        quad[3].position.x = x0;
+        quad[3].position.y = y1;
+
+        for (int k = 0; k < 4; k++) {
+            quad[k].color = color;
+            quad[k].tex_coord.x = 0;
+            quad[k].tex_coord.y = 0;
+        }
+    }
+
+    return count;
+}
+
+const int* particlesIndices() {
+    return indices;
+}
@@ -0,0 +1,60 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include "game.h"
+
+// Fixed capacity, a multiple of the SIMD width
+const int PARTICLE_COUNT = 1 << 17;
+
+const int PARTICLE_SIZE = 2;
+const float PARTICLE_DRAG = 0.98f;
+
+// Structure of arrays so the update kernel works on 4 particles at once.
+// life runs from 1 down to 0 by fade every tick and drives the alpha.
+struct Particles {
+    alignas(16) float x[PARTICLE_COUNT];
+    alignas(16) float y[PARTICLE_COUNT];
+    alignas(16) float vX[PARTICLE_COUNT];
+    alignas(16) float vY[PARTICLE_COUNT];
+    alignas(16) float life[PARTICLE_COUNT];
+    alignas(16) float fade[PARTICLE_COUNT];
+    SDL_Color color[PARTICLE_COUNT];
+    int count;
+    uint32_t seed;
+};
+
+// What the renderer needs of each particle, captured once per tick so
+// drawing can happen on another thread
+struct ParticleFrame {
+    alignas(16) float x[PARTICLE_COUNT];
+    alignas(16) float y[PARTICLE_COUNT];
+    SDL_Color color[PARTICLE_COUNT];
+    int count;
+};
+
+void particlesInit(struct Particles* particles);
+
+// Bursts for the gameplay events of the last tick
+void particlesEmitEvents(struct Particles* particles, const struct Game* game);
+
+// Adds up to count particles around (x, y), spread around direction (dirX, dirY)
+void particlesEmit(struct Particles* particles, float x, float y, int count, float dirX, float dirY, float speed, SDL_Color color);
+
+// One tick of gravity, drag and lifetime, then drops dead particles
+void particlesUpdate(struct Particles* particles, float gravity, float drag);
+
+// Same as particlesUpdate without SIMD, used on other targets and as a reference
+void particlesUpdateScalar(struct Particles* particles, float gravity, float drag);
+
+// Copies positions and faded colors
+void particlesCapture(const struct Particles* particles, struct ParticleFrame* frame);
+
+// Fills 4 vertices per particle, returns how many particles were written
+int particlesGeometry(const struct ParticleFrame* frame, SDL_Vertex* vertices, int maxParticles);
+
+// Index buffer shared by every frame, 6 indices per particle
+const int* particlesIndices();
+
+#endif
@@ -0,0 +1,59 @@
+// Particle system benchmark: keeps the buffer full and times the update
+// kernel, and capture plus vertex generation, against a 60 fps frame budget
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "particles.h"
+
+const int FRAMES = 600;
+
+struct Particles particles;
+struct ParticleFrame frame;
+SDL_Vertex vertices[PARTICLE_COUNT * 4];
+
+typedef void (*UpdateFunction)(struct Particles*, float, float);
+
+// Tops the buffer up to capacity, so every frame works on PARTICLE_COUNT particles
+static void refill() {
+    const SDL_Color color = { 0x8a, 0x1c, 0x1c, 0xff };
+    while (particles.count < PARTICLE_COUNT) {
+        particlesEmit(&particles, rand() % SCREEN_WIDTH, rand() % (SCREEN_HEIGHT / 2), 200, 0, -1, 6, color);
+    }
+}
+
+static double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void bench(const char* name, UpdateFunction update) {
+
+    double updateTime = 0, geometryTime = 0;
+    long long updated = 0;
+
+    particlesInit(&particles);
+
+    for (int i = 0; i < FRAMES; i++) {
+        refill();
+        updated += particles.count;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        update(&particles, world.gravity, PARTICLE_DRAG);
+        updateTime += elapsed(start);
+
+        start = std::chrono::steady_clock::now();
+        particlesCapture(&particles, &frame);
+        particlesGeometry(&frame, vertices, PARTICLE_COUNT);
+        geometryTime += elapsed(start);
+    }
+
+    printf("%-7s %d particles: update %.3f ms, geometry %.3f ms per frame (%.2f ns per particle, budget 16.7 ms)\n",
+        name, PARTICLE_COUNT, updateTime / FRAMES, geometryTime / FRAMES, (updateTime + geometryTime) * 1e6 / updated);
+}
+
+int main(int argc, char* args[]) {
+
+    bench("scalar", particlesUpdateScalar);
+    bench("simd", particlesUpdate);
+
+    return 0;
+}
@@ -0,0 +1,307 @@
+// Dedicated server: runs the authoritative simulation without a window
+// and streams delta-compressed snapshots to every connected client
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <thread>
+#include "game.h"
+#include "net.h"
+
+// Silent clients are dropped after this many ms
+const int CLIENT_TIMEOUT = 5000;
+
+// Inputs queued ahead of the simulation, older ones are skipped to keep latency down
+const int INPUT_BUFFER = 64;
+const int INPUT_MAX_LAG = 8;
+
+struct Client {
+    bool connected = false;
+    struct NetAddress address;
+    uint32_t lastHeard;
+    uint32_t ackTick;
+    uint32_t lastSeq;
+    uint32_t newestSeq;
+    uint8_t inputs[INPUT_BUFFER];
+    uint8_t input;
+
+    // Bytes sent beyond the rate so far, no snapshot until it is paid off
+    int rateDebt;
+
+    // Where the next snapshot starts handing out its byte budget
+    int cursor;
+
+    // Events since the last snapshot this client got
+    struct Event events[EVENT_COUNT];
+    int eventCount;
+};
+
+struct Game game;
+struct NetSocket sock;
+struct Client clients[MAX_SURVIVORS];
+
+// What each client's snapshots actually carried, indexed by tick % NET_HISTORY
+struct NetState history[MAX_SURVIVORS][NET_HISTORY];
+
+static struct Client* findClient(const struct NetAddress* address) {
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        if (clients[i].connected && netSameAddress(&clients[i].address, address)) {
+            return &clients[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void dropClient(int slot) {
+    printf("Survivor %d left\n", slot);
+    clients[slot].connected = false;
+    gameLeave(&game, slot);
+}
+
+static void handleConnect(const struct NetAddress* from) {
+
+    struct Client* client = findClient(from);
+    int slot = client != NULL ? client - clients : gameJoin(&game);
+
+    if (slot == -1) {
+        uint8_t packet = MSG_REJECT;
+        netSend(&sock, from, &packet, 1);
+        return;
+    }
+
+    if (client == NULL) {
+        client = &clients[slot];
+        *client = Client();
+        client->connected = true;
+        client->address = *from;
+        client->ackTick = NET_NO_BASE;
+        client->lastSeq = 0;
+        client->newestSeq = 0;
+        client->input = 0;
+        client->rateDebt = 0;
+        client->cursor = 0;
+        client->eventCount = 0;
+
+        // Baselines of whoever had the slot before are no use
+        for (int i = 0; i < NET_HISTORY; i++) {
+            history[slot][i].tick = 0;
+        }
+        printf("Survivor %d joined\n", slot);
+    }
+
+    client->lastHeard = netTime();
+
+    uint8_t packet[2] = { MSG_ACCEPT, (uint8_t)slot };
+    netSend(&sock, from, packet, 2);
+}
+
+static void handleInput(struct Client* client, const uint8_t* data, int size) {
+
+    if (size < 10 || size < 10 + data[9]) {
+        return;
+    }
+
+    uint32_t ackTick = netGet32(data + 1);
+    uint32_t newestSeq = netGet32(data + 5);
+    int count = data[9];
+
+    if (ackTick != NET_NO_BASE && ackTick <= game.tick && (client->ackTick == NET_NO_BASE || ackTick > client->ackTick)) {
+        client->ackTick = ackTick;
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint32_t seq = newestSeq - count + 1 + i;
+        if (seq > client->lastSeq) {
+            client->inputs[seq % INPUT_BUFFER] = data[10 + i];
+        }
+    }
+
+    if (newestSeq > client->newestSeq) {
+        client->newestSeq = newestSeq;
+    }
+
+    client->lastHeard = netTime();
+}
+
+static void receivePackets() {
+
+    uint8_t data[NET_MAX_PACKET];
+    struct NetAddress from;
+    int size;
+
+    while ((size = netReceive(&sock, &from, data, sizeof(data))) > 0) {
+
+        struct Client* client = findClient(&from);
+
+        switch (data[0]) {
+            case MSG_CONNECT:
+                handleConnect(&from);
+                break;
+            case MSG_INPUT:
+                if (client != NULL) {
+                    handleInput(client, data, size);
+                }
+                break;
+            case MSG_DISCONNECT:
+                if (client != NULL) {
+                    dropClient(client - clients);
+                }
+                break;
+        }
+    }
+}
+
+static void sendSnapshots() {
+
+    static struct NetState state;
+    netCapture(&game, &state);
+
+    uint8_t data[NET_SNAPSHOT_BUDGET];
+
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        struct Client* client = &clients[i];
+        if (!client->connected) {
+            continue;
+        }
+
+        for (int k = 0; k < game.eventCount && client->eventCount < EVENT_COUNT; k++) {
+            client->events[client->eventCount++] = game.events[k];
+        }
+
+        // Stay within the client's rate by skipping ticks
+        client->rateDebt -= NET_CLIENT_RATE / TICK_RATE;
+        if (client->rateDebt < 0) {
+            client->rateDebt = 0;
+        }
+        if (client->rateDebt > 0) {
+            continue;
+        }
+
+        // Delta against the newest state the client confirmed, if still kept
+        const struct NetState* base = NULL;
+        if (client->ackTick != NET_NO_BASE && game.tick - client->ackTick < (uint32_t)NET_HISTORY &&
+            history[i][client->ackTick % NET_HISTORY].tick == client->ackTick) {
+            base = &history[i][client->ackTick % NET_HISTORY];
+        }
+
+        data[0] = MSG_SNAPSHOT;
+        netPut32(data + 1, game.tick);
+        netPut32(data + 5, base != NULL ? client->ackTick : NET_NO_BASE);
+        netPut32(data + 9, client->lastSeq);
+        data[13] = i;
+
+        // Events go with the next snapshot, a lost one only loses their effects.
+        // Entities that don't fit the budget follow in later snapshots.
+        int eventSize = netWriteEvents(client->events, client->eventCount, data + 14, sizeof(data) - 14);
+        int size = eventSize < 0 ? -1 : netWriteDelta(base, &state, &client->cursor, data + 14 + eventSize, sizeof(data) - 14 - eventSize, &history[i][game.tick % NET_HISTORY]);
+        if (size < 0) {
+            printf("Snapshot too large!\n");
+            continue;
+        }
+
+        netSend(&sock, &client->address, data, 14 + eventSize + size);
+        client->rateDebt += 14 + eventSize + size;
+        client->eventCount = 0;
+    }
+}
+
+static void tick() {
+
+    uint8_t inputs[MAX_SURVIVORS] = { 0 };
+    uint32_t now = netTime();
+
+    for (int i = 0; i < MAX_SURVIVORS; i++) {
+        struct Client* client = &clients[i];
+        if (!client->connected) {
+            continue;
+        }
+
+        if (now - client->lastHeard > (uint32_t)CLIENT_TIMEOUT) {
+            dropClient(i);
+            continue;
+        }
+
+        // One input per tick, the last one is held when the next is late
+        if (client->newestSeq > client->lastSeq) {
+            if (client->newestSeq - client->lastSeq > (uint32_t)INPUT_MAX_LAG) {
+                client->lastSeq = client->newestSeq - INPUT_MAX_LAG;
+            }
+            client->lastSeq++;
+            client->input = client->inputs[client->lastSeq % INPUT_BUFFER];
+        }
+
+        inputs[i] = client->input;
+    }
+
+    gameUpdate(&game, inputs);
+    sendSnapshots();
+}
+
+int main(int argc, char* args[]) {
+
+    int port = NET_PORT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(args[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(args[++i]);
+        } else if (strcmp(args[i], "--lag") == 0 && i + 1 < argc) {
+            sock.shim.latency = atoi(args[++i]);
+        } else if (strcmp(args[i], "--jitter") == 0 && i + 1 < argc) {
+            sock.shim.jitter = atoi(args[++i]);
+        } else if (strcmp(args[i], "--loss") == 0 && i + 1 < argc) {
+            sock.shim.loss = atoi(args[++i]);
+        } else {
+            printf("Usage: %s [--port N] [--lag ms] [--jitter ms] [--loss percent]\n", args[0]);
+            return 1;
+        }
+    }
+
+    if (!netOpen(&sock, port)) {
+        return 1;
+    }
+
+    gameInit(&game, time(NULL));
+    printf("Server listening on port %d\n", port);
+
+    const std::chrono::microseconds tickLength(1000000 / TICK_RATE);
+    std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
+    uint32_t lastReport = netTime();
+    unsigned int lastBytes = 0;
+
+    while (true) {
+
+        receivePackets();
+        tick();
+        netFlush(&sock);
+
+        // Bandwidth report
+        uint32_t now = netTime();
+        if (now - lastReport >= 5000) {
+            int connected = 0;
+            for (int i = 0; i < MAX_SURVIVORS; i++) {
+                connected += clients[i].connected;
+            }
+
+            if (connected > 0) {
+                float rate = (sock.bytesSent - lastBytes) / ((now - lastReport) / 1000.0f) / connected;
+                printf("Clients: %d - Score: %d - %.0f bytes/s per client\n", connected, game.score, rate);
+            }
+
+            lastReport = now;
+            lastBytes = sock.bytesSent;
+        }
+
+        // Fixed tick rate, keep flushing the shim while waiting
+        nextTick += tickLength;
+        while (std::chrono::steady_clock::now() < nextTick) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            netFlush(&sock);
+        }
+    }
+
+    netClose(&sock);
+
+    return 0;
+}
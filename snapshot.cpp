@@ -0,0 +1,24 @@
+#include "snapshot.h"
+
+// Set on the middle index while it holds a snapshot the consumer has not seen
+static const int FRESH = 4;
+
+struct RenderSnapshot* snapshotBack(struct TripleBuffer* buffer) {
+    return &buffer->buffers[buffer->back];
+}
+
+void snapshotPublish(struct TripleBuffer* buffer) {
+
+    // Release so the snapshot contents are visible before its index
+    buffer->back = buffer->middle.exchange(buffer->back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+const struct RenderSnapshot* snapshotAcquire(struct TripleBuffer* buffer, bool* fresh) {
+
+    *fresh = buffer->middle.load(std::memory_order_relaxed) & FRESH;
+    if (*fresh) {
+        buffer->front = buffer->middle.exchange(buffer->front, std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    return &buffer->buffers[buffer->front];
+}
@@ -0,0 +1,50 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include "game.h"
+#include "particles.h"
+
+const int HUD_TEXT_SIZE = 64;
+
+struct Sprite {
+    SDL_Rect src;
+    SDL_Rect dst;
+    SDL_RendererFlip flip;
+};
+
+// Everything needed to draw one tick, written by the simulation thread
+// and never touched again until the renderer hands it back
+struct RenderSnapshot {
+    struct Sprite bullets[BULLET_COUNT];
+    int bulletCount;
+    struct Sprite survivors[MAX_SURVIVORS];
+    int survivorCount;
+    struct Sprite zombies[ZOMBIE_COUNT];
+    int zombieCount;
+    struct ParticleFrame particles;
+    char text[HUD_TEXT_SIZE];
+};
+
+// Lock-free triple buffer. The producer always owns a back buffer to fill
+// and the consumer always owns the front one it draws, so neither waits.
+// The third buffer is exchanged between them with a single atomic.
+struct TripleBuffer {
+    struct RenderSnapshot buffers[3];
+    std::atomic<int> middle{ 1 };
+    int back = 0;
+    int front = 2;
+};
+
+// Buffer the producer should fill next
+struct RenderSnapshot* snapshotBack(struct TripleBuffer* buffer);
+
+// Publishes the back buffer as the newest snapshot
+void snapshotPublish(struct TripleBuffer* buffer);
+
+// Newest published snapshot, the same one again if nothing new arrived,
+// fresh tells which
+const struct RenderSnapshot* snapshotAcquire(struct TripleBuffer* buffer, bool* fresh);
+
+#endif